@@ -0,0 +1,344 @@
+#ifndef DATAINTENSIVE_AVLTREE_HPP
+#define DATAINTENSIVE_AVLTREE_HPP
+
+#include <algorithm>
+#include <functional>
+#include "MemCache.h"
+#include "HashIndex.hpp"
+
+/*
+ * Self balancing alternative to BST. The heights of the two subtrees of every node differ by at most one, so
+ * the tree stays O(log n) deep even when keys are inserted in sorted order, which turns BST into a linked list.
+ */
+template<class K, class V>
+class AVLTree : public MemCache<K, V> {
+public:
+
+    /*
+     * With hashIndex, a HashIndex of every node is kept next to the tree, so get and inserts of existing keys don't
+     * walk the tree. Sorted iteration is unaffected.
+     */
+    explicit AVLTree(bool hashIndex = false);
+    AVLTree(const AVLTree&) = delete;
+    AVLTree& operator=(const AVLTree&) = delete;
+    std::optional<V> get(const K& k) const override;
+    void insert(const K& k, const V& v) override;
+    bool remove(const K& key) override;
+    void traverseSorted(const std::function<void(const K& k, const V& v)>& callback) const override;
+    std::unique_ptr<typename MemCache<K, V>::Cursor> newCursor() const override;
+    size_t size() const override;
+    size_t memoryUsage() const override;
+    void clear() override;
+    ~AVLTree() override;
+
+    /*
+     * Height of the tree, an empty tree has height 0
+     */
+    int height() const;
+
+private:
+
+    struct Node {
+        Node(K k, V v) : key(std::move(k)), value(std::move(v)) {};
+        K key;
+        V value;
+        Node *left = nullptr, *right = nullptr;
+        int height = 1;
+    };
+
+    /*
+     * In order traversal with an explicit stack, the top of the stack is the current node
+     */
+    class SortedCursor : public MemCache<K, V>::Cursor {
+    public:
+        explicit SortedCursor(Node *root) {
+            pushLeft(root);
+        };
+        bool valid() const override { return !nodes.empty(); }
+        const K& key() const override { return nodes.top()->key; }
+        const V& value() const override { return nodes.top()->value; }
+        void next() override {
+            auto curr = nodes.top();
+            nodes.pop();
+            pushLeft(curr->right);
+        }
+
+    private:
+        std::stack<Node*> nodes;
+
+        void pushLeft(Node *curr){
+            while (curr){
+                nodes.push(curr);
+                curr = curr->left;
+            }
+        }
+    };
+
+    Node *root = nullptr;
+    size_t treeSize = 0;
+    size_t bytes = 0;
+    std::optional<HashIndex<K, Node>> index;
+
+    Node* insertRecursive(Node *curr, const K& k, const V& v);
+    Node* removeRecursive(Node *curr, const K& key, bool &removed);
+    static Node* removeMin(Node *curr, Node *&min);
+    static size_t entrySize(const K& k, const V& v);
+    static Node* rebalance(Node *node);
+    static Node* rotateLeft(Node *node);
+    static Node* rotateRight(Node *node);
+    static void updateHeight(Node *node);
+    static int heightOf(const Node *node);
+    static int balanceFactor(const Node *node);
+};
+
+template<class K, class V>
+AVLTree<K, V>::AVLTree(bool hashIndex) {
+    if (hashIndex){
+        index.emplace();
+    }
+}
+
+template<class K, class V>
+std::optional<V> AVLTree<K, V>::get(const K &k) const {
+    if (index.has_value()){
+        auto node = index->find(k);
+        return node ? std::optional<V>(node->value) : std::nullopt;
+    }
+
+    auto curr = root;
+    while (curr){
+        if (k < curr->key){
+            curr = curr->left;
+        } else if (curr->key < k){
+            curr = curr->right;
+        } else {
+            return curr->value;
+        }
+    }
+
+    return std::nullopt;
+}
+
+template<class K, class V>
+void AVLTree<K, V>::insert(const K &k, const V &v) {
+    if (index.has_value()){
+        if (auto node = index->find(k)){
+            bytes -= approximateHeapSize(node->value);
+            bytes += approximateHeapSize(v);
+            node->value = v;
+            return;
+        }
+    }
+
+    root = insertRecursive(root, k, v);
+}
+
+template<class K, class V>
+bool AVLTree<K, V>::remove(const K &key) {
+    bool removed = false;
+    root = removeRecursive(root, key, removed);
+    return removed;
+}
+
+template<class K, class V>
+void AVLTree<K, V>::traverseSorted(const std::function<void(const K &, const V &)> &callback) const {
+    std::stack<Node*> nodes;
+    auto curr = root;
+    while (curr || !nodes.empty()){
+        while (curr){
+            nodes.push(curr);
+            curr = curr->left;
+        }
+
+        curr = nodes.top();
+        nodes.pop();
+        callback(curr->key, curr->value);
+        curr = curr->right;
+    }
+}
+
+template<class K, class V>
+std::unique_ptr<typename MemCache<K, V>::Cursor> AVLTree<K, V>::newCursor() const {
+    return std::make_unique<SortedCursor>(root);
+}
+
+template<class K, class V>
+size_t AVLTree<K, V>::size() const {
+    return treeSize;
+}
+
+template<class K, class V>
+size_t AVLTree<K, V>::memoryUsage() const {
+    return bytes + (index.has_value() ? index->memoryUsage() : 0);
+}
+
+template<class K, class V>
+void AVLTree<K, V>::clear() {
+    std::stack<Node*> nodes;
+    if (root){
+        nodes.push(root);
+    }
+
+    while (!nodes.empty()){
+        auto curr = nodes.top();
+        nodes.pop();
+        if (curr->left){
+            nodes.push(curr->left);
+        }
+        if (curr->right){
+            nodes.push(curr->right);
+        }
+        delete curr;
+    }
+
+    root = nullptr;
+    treeSize = 0;
+    bytes = 0;
+    if (index.has_value()){
+        index->clear();
+    }
+}
+
+template<class K, class V>
+AVLTree<K, V>::~AVLTree() {
+    clear();
+}
+
+template<class K, class V>
+int AVLTree<K, V>::height() const {
+    return heightOf(root);
+}
+
+template<class K, class V>
+typename AVLTree<K, V>::Node *AVLTree<K, V>::insertRecursive(Node *curr, const K &k, const V &v) {
+    if (!curr){
+        treeSize++;
+        bytes += entrySize(k, v);
+        auto node = new Node(k, v);
+        if (index.has_value()){
+            index->insert(k, node);
+        }
+        return node;
+    }
+
+    if (k < curr->key){
+        curr->left = insertRecursive(curr->left, k, v);
+    } else if (curr->key < k){
+        curr->right = insertRecursive(curr->right, k, v);
+    } else {
+        bytes -= approximateHeapSize(curr->value);
+        bytes += approximateHeapSize(v);
+        curr->value = v;
+        return curr;
+    }
+
+    return rebalance(curr);
+}
+
+template<class K, class V>
+typename AVLTree<K, V>::Node *AVLTree<K, V>::removeRecursive(Node *curr, const K &key, bool &removed) {
+    if (!curr){
+        return nullptr;
+    }
+
+    if (key < curr->key){
+        curr->left = removeRecursive(curr->left, key, removed);
+        return rebalance(curr);
+    } else if (curr->key < key){
+        curr->right = removeRecursive(curr->right, key, removed);
+        return rebalance(curr);
+    }
+
+    removed = true;
+    treeSize--;
+    bytes -= entrySize(curr->key, curr->value);
+    if (index.has_value()){
+        index->erase(key);
+    }
+    auto left = curr->left, right = curr->right;
+    delete curr;
+    if (!right){
+        return left;
+    }
+
+    // Replace the removed node with the smallest node of its right subtree
+    Node *successor = nullptr;
+    right = removeMin(right, successor);
+    successor->left = left;
+    successor->right = right;
+    return rebalance(successor);
+}
+
+template<class K, class V>
+typename AVLTree<K, V>::Node *AVLTree<K, V>::removeMin(Node *curr, Node *&min) {
+    if (!curr->left){
+        min = curr;
+        return curr->right;
+    }
+
+    curr->left = removeMin(curr->left, min);
+    return rebalance(curr);
+}
+
+template<class K, class V>
+size_t AVLTree<K, V>::entrySize(const K &k, const V &v) {
+    return sizeof(Node) + approximateHeapSize(k) + approximateHeapSize(v);
+}
+
+template<class K, class V>
+typename AVLTree<K, V>::Node *AVLTree<K, V>::rebalance(Node *node) {
+    updateHeight(node);
+    auto balance = balanceFactor(node);
+    if (balance > 1){
+        if (balanceFactor(node->left) < 0){
+            node->left = rotateLeft(node->left);
+        }
+        return rotateRight(node);
+    }
+
+    if (balance < -1){
+        if (balanceFactor(node->right) > 0){
+            node->right = rotateRight(node->right);
+        }
+        return rotateLeft(node);
+    }
+
+    return node;
+}
+
+template<class K, class V>
+typename AVLTree<K, V>::Node *AVLTree<K, V>::rotateLeft(Node *node) {
+    auto newRoot = node->right;
+    node->right = newRoot->left;
+    newRoot->left = node;
+    updateHeight(node);
+    updateHeight(newRoot);
+    return newRoot;
+}
+
+template<class K, class V>
+typename AVLTree<K, V>::Node *AVLTree<K, V>::rotateRight(Node *node) {
+    auto newRoot = node->left;
+    node->left = newRoot->right;
+    newRoot->right = node;
+    updateHeight(node);
+    updateHeight(newRoot);
+    return newRoot;
+}
+
+template<class K, class V>
+void AVLTree<K, V>::updateHeight(Node *node) {
+    node->height = 1 + std::max(heightOf(node->left), heightOf(node->right));
+}
+
+template<class K, class V>
+int AVLTree<K, V>::heightOf(const Node *node) {
+    return node ? node->height : 0;
+}
+
+template<class K, class V>
+int AVLTree<K, V>::balanceFactor(const Node *node) {
+    return heightOf(node->left) - heightOf(node->right);
+}
+
+#endif
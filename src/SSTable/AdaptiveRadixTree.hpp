@@ -0,0 +1,838 @@
+#ifndef DATAINTENSIVE_ADAPTIVERADIXTREE_HPP
+#define DATAINTENSIVE_ADAPTIVERADIXTREE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include "MemCache.h"
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+
+/*
+ * Adaptive radix tree (Leis et al., "The Adaptive Radix Tree: ARTful Indexing for Main-Memory Databases").
+ * Inner nodes branch on one byte of the key and come in four sizes (4, 16, 48 and 256 children), growing and
+ * shrinking as children are added and removed. Chains of single child nodes are collapsed into a prefix stored
+ * in the node below them, and a key is stored in a leaf as soon as no other key shares its path.
+ *
+ * Lookups compare each byte of the key at most once, instead of comparing whole keys at every level like BST.
+ * Children are kept in byte order, so traverseSorted is a plain depth first walk.
+ *
+ * A key that is a prefix of other keys ends at an inner node, and is stored as that node's terminal leaf.
+ */
+template<class V>
+class AdaptiveRadixTree : public MemCache<std::string, V> {
+public:
+
+    AdaptiveRadixTree() = default;
+    AdaptiveRadixTree(const AdaptiveRadixTree&) = delete;
+    AdaptiveRadixTree& operator=(const AdaptiveRadixTree&) = delete;
+    std::optional<V> get(const std::string& k) const override;
+    void insert(const std::string& k, const V& v) override;
+    bool remove(const std::string& key) override;
+    void traverseSorted(const std::function<void(const std::string& k, const V& v)>& callback) const override;
+    std::unique_ptr<typename MemCache<std::string, V>::Cursor> newCursor() const override;
+    size_t size() const override;
+    /*
+     * Counts leaves and inner nodes, but not the compressed path held by each inner node
+     */
+    size_t memoryUsage() const override;
+    void clear() override;
+    ~AdaptiveRadixTree() override;
+
+private:
+
+    enum class NodeType : uint8_t {
+        NODE4, NODE16, NODE48, NODE256
+    };
+
+    struct Leaf {
+        Leaf(std::string key, V value) : key(std::move(key)), value(std::move(value)) {};
+        std::string key;
+        V value;
+    };
+
+    struct Node;
+
+    /*
+     * Pointer to a child, which is either a leaf or an inner node. Leaves are tagged in the lowest bit.
+     */
+    struct Ref {
+        Ref() = default;
+        Ref(Leaf *leaf) : bits(reinterpret_cast<uintptr_t>(leaf) | 1) {};
+        Ref(Node *node) : bits(reinterpret_cast<uintptr_t>(node)) {};
+        bool empty() const { return bits == 0; }
+        bool isLeaf() const { return bits & 1; }
+        Leaf* leaf() const { return reinterpret_cast<Leaf*>(bits & ~static_cast<uintptr_t>(1)); }
+        Node* node() const { return reinterpret_cast<Node*>(bits); }
+
+        uintptr_t bits = 0;
+    };
+
+    struct Node {
+        explicit Node(NodeType type) : type(type) {};
+        NodeType type;
+        uint16_t numChildren = 0;
+        /*
+         * Bytes shared by every key below this node, after the byte that selected it
+         */
+        std::string prefix;
+        Leaf *terminal = nullptr;
+    };
+
+    /*
+     * Node4 and Node16 keep their keys sorted, with children[i] belonging to keys[i]
+     */
+    struct Node4 : Node {
+        Node4() : Node(NodeType::NODE4) {};
+        uint8_t keys[4]{};
+        Ref children[4];
+    };
+
+    struct Node16 : Node {
+        Node16() : Node(NodeType::NODE16) {};
+        uint8_t keys[16]{};
+        Ref children[16];
+    };
+
+    /*
+     * childIndex[byte] is one more than the position of the byte's child, or 0 if there is none
+     */
+    struct Node48 : Node {
+        Node48() : Node(NodeType::NODE48) {};
+        uint8_t childIndex[256]{};
+        Ref children[48];
+    };
+
+    struct Node256 : Node {
+        Node256() : Node(NodeType::NODE256) {};
+        Ref children[256];
+    };
+
+    /*
+     * Depth first walk with an explicit stack. Every frame holds an inner node on the path to the current leaf
+     * and the byte its next child to visit is at or after.
+     */
+    class SortedCursor : public MemCache<std::string, V>::Cursor {
+    public:
+        explicit SortedCursor(Ref root) {
+            if (!root.empty()){
+                descend(root);
+            }
+        };
+        bool valid() const override { return leaf; }
+        const std::string& key() const override { return leaf->key; }
+        const V& value() const override { return leaf->value; }
+        void next() override { advance(); }
+
+    private:
+        struct Frame {
+            const Node *node;
+            int nextByte;
+        };
+        std::stack<Frame> frames;
+        const Leaf *leaf = nullptr;
+
+        void descend(Ref ref){
+            if (ref.isLeaf()){
+                leaf = ref.leaf();
+                return;
+            }
+
+            frames.push({ref.node(), 0});
+            if (ref.node()->terminal){
+                leaf = ref.node()->terminal;
+                return;
+            }
+            advance();
+        }
+
+        void advance(){
+            while (!frames.empty()){
+                auto &frame = frames.top();
+                auto child = childAtOrAfter(frame.node, frame.nextByte);
+                if (!child.has_value()){
+                    frames.pop();
+                    continue;
+                }
+
+                frame.nextByte = child->first + 1;
+                descend(child->second);
+                return;
+            }
+            leaf = nullptr;
+        }
+    };
+
+    Ref root;
+    size_t treeSize = 0;
+    size_t bytes = 0;
+
+    static Ref* findChild(Node *node, uint8_t byte);
+    static const Ref* findChild(const Node *node, uint8_t byte);
+    /*
+     * Adds a child to the node held by slot, replacing it with a larger node if it is full
+     */
+    void addChild(Ref &slot, uint8_t byte, Ref child);
+    /*
+     * Removes a child from the node held by slot, replacing it with a smaller node or its only child when it
+     * gets sparse enough
+     */
+    void removeChild(Ref &slot, uint8_t byte);
+    void shrink(Ref &slot);
+    Leaf* newLeaf(const std::string &k, const V &v);
+    void freeLeaf(Leaf *leaf);
+    template<class T>
+    T* newNode();
+    void freeNode(Node *node);
+    static size_t nodeSize(NodeType type);
+    void placeLeaf(Node4 *node, Leaf *leaf, size_t depth);
+    static void moveHeader(Node *from, Node *to);
+    static void forEachChild(const Node *node, const std::function<void(uint8_t byte, Ref child)> &callback);
+    /*
+     * The child with the smallest byte that is at least byte, if any
+     */
+    static std::optional<std::pair<int, Ref>> childAtOrAfter(const Node *node, int byte);
+    static void traverse(Ref ref, const std::function<void(const std::string& k, const V& v)>& callback);
+    static void deleteNode(Node *node);
+    static void deleteRecursive(Ref ref);
+};
+
+template<class V>
+std::optional<V> AdaptiveRadixTree<V>::get(const std::string &k) const {
+    auto ref = &root;
+    size_t depth = 0;
+    while (!ref->empty()){
+        if (ref->isLeaf()){
+            if (ref->leaf()->key == k){
+                return ref->leaf()->value;
+            }
+            return std::nullopt;
+        }
+
+        auto node = ref->node();
+        if (k.compare(depth, node->prefix.size(), node->prefix) != 0){
+            return std::nullopt;
+        }
+        depth += node->prefix.size();
+        if (depth == k.size()){
+            return node->terminal ? std::optional<V>(node->terminal->value) : std::nullopt;
+        }
+
+        ref = findChild(static_cast<const Node*>(node), static_cast<uint8_t>(k[depth]));
+        if (!ref){
+            return std::nullopt;
+        }
+        depth++;
+    }
+
+    return std::nullopt;
+}
+
+template<class V>
+void AdaptiveRadixTree<V>::insert(const std::string &k, const V &v) {
+    auto slot = &root;
+    size_t depth = 0;
+    while (true){
+        if (slot->empty()){
+            *slot = newLeaf(k, v);
+            treeSize++;
+            return;
+        }
+
+        if (slot->isLeaf()){
+            auto leaf = slot->leaf();
+            if (leaf->key == k){
+                bytes -= approximateHeapSize(leaf->value);
+                bytes += approximateHeapSize(v);
+                leaf->value = v;
+                return;
+            }
+
+            // Lazy expansion: the leaf only gets an inner node above it once another key shares its path
+            auto node = newNode<Node4>();
+            auto common = depth;
+            while (common < k.size() && common < leaf->key.size() && k[common] == leaf->key[common]){
+                common++;
+            }
+            node->prefix = k.substr(depth, common - depth);
+            placeLeaf(node, leaf, common);
+            placeLeaf(node, newLeaf(k, v), common);
+            *slot = node;
+            treeSize++;
+            return;
+        }
+
+        auto node = slot->node();
+        size_t mismatch = 0;
+        while (mismatch < node->prefix.size() && depth + mismatch < k.size() && node->prefix[mismatch] == k[depth + mismatch]){
+            mismatch++;
+        }
+
+        if (mismatch < node->prefix.size()){
+            // The key leaves the compressed path, split it at the first differing byte
+            auto parent = newNode<Node4>();
+            parent->prefix = node->prefix.substr(0, mismatch);
+            auto byte = static_cast<uint8_t>(node->prefix[mismatch]);
+            node->prefix.erase(0, mismatch + 1);
+            parent->keys[0] = byte;
+            parent->children[0] = node;
+            parent->numChildren = 1;
+            placeLeaf(parent, newLeaf(k, v), depth + mismatch);
+            *slot = parent;
+            treeSize++;
+            return;
+        }
+
+        depth += node->prefix.size();
+        if (depth == k.size()){
+            if (node->terminal){
+                bytes -= approximateHeapSize(node->terminal->value);
+                bytes += approximateHeapSize(v);
+                node->terminal->value = v;
+            } else {
+                node->terminal = newLeaf(k, v);
+                treeSize++;
+            }
+            return;
+        }
+
+        auto byte = static_cast<uint8_t>(k[depth]);
+        auto child = findChild(node, byte);
+        if (!child){
+            addChild(*slot, byte, newLeaf(k, v));
+            treeSize++;
+            return;
+        }
+
+        slot = child;
+        depth++;
+    }
+}
+
+template<class V>
+bool AdaptiveRadixTree<V>::remove(const std::string &key) {
+    Ref *parent = nullptr;
+    uint8_t parentByte = 0;
+    auto slot = &root;
+    size_t depth = 0;
+    while (!slot->empty()){
+        if (slot->isLeaf()){
+            auto leaf = slot->leaf();
+            if (leaf->key != key){
+                return false;
+            }
+
+            freeLeaf(leaf);
+            treeSize--;
+            if (parent){
+                removeChild(*parent, parentByte);
+            } else {
+                root = Ref();
+            }
+            return true;
+        }
+
+        auto node = slot->node();
+        if (key.compare(depth, node->prefix.size(), node->prefix) != 0){
+            return false;
+        }
+        depth += node->prefix.size();
+        if (depth == key.size()){
+            if (!node->terminal){
+                return false;
+            }
+
+            freeLeaf(node->terminal);
+            node->terminal = nullptr;
+            treeSize--;
+            shrink(*slot);
+            return true;
+        }
+
+        auto byte = static_cast<uint8_t>(key[depth]);
+        auto child = findChild(node, byte);
+        if (!child){
+            return false;
+        }
+
+        parent = slot;
+        parentByte = byte;
+        slot = child;
+        depth++;
+    }
+
+    return false;
+}
+
+template<class V>
+void AdaptiveRadixTree<V>::traverseSorted(const std::function<void(const std::string &, const V &)> &callback) const {
+    traverse(root, callback);
+}
+
+template<class V>
+std::unique_ptr<typename MemCache<std::string, V>::Cursor> AdaptiveRadixTree<V>::newCursor() const {
+    return std::make_unique<SortedCursor>(root);
+}
+
+template<class V>
+size_t AdaptiveRadixTree<V>::size() const {
+    return treeSize;
+}
+
+template<class V>
+size_t AdaptiveRadixTree<V>::memoryUsage() const {
+    return bytes;
+}
+
+template<class V>
+void AdaptiveRadixTree<V>::clear() {
+    deleteRecursive(root);
+    root = Ref();
+    treeSize = 0;
+    bytes = 0;
+}
+
+template<class V>
+AdaptiveRadixTree<V>::~AdaptiveRadixTree() {
+    clear();
+}
+
+template<class V>
+typename AdaptiveRadixTree<V>::Ref* AdaptiveRadixTree<V>::findChild(Node *node, uint8_t byte) {
+    return const_cast<Ref*>(findChild(static_cast<const Node*>(node), byte));
+}
+
+template<class V>
+const typename AdaptiveRadixTree<V>::Ref* AdaptiveRadixTree<V>::findChild(const Node *node, uint8_t byte) {
+    switch (node->type) {
+        case NodeType::NODE4: {
+            auto n = static_cast<const Node4*>(node);
+            for (int i = 0; i < n->numChildren; i++){
+                if (n->keys[i] == byte){
+                    return &n->children[i];
+                }
+            }
+            return nullptr;
+        }
+        case NodeType::NODE16: {
+            auto n = static_cast<const Node16*>(node);
+#ifdef __SSE2__
+            auto matches = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(byte)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(n->keys)));
+            auto mask = static_cast<uint32_t>(_mm_movemask_epi8(matches)) & ((1u << n->numChildren) - 1);
+            return mask ? &n->children[__builtin_ctz(mask)] : nullptr;
+#else
+            for (int i = 0; i < n->numChildren; i++){
+                if (n->keys[i] == byte){
+                    return &n->children[i];
+                }
+            }
+            return nullptr;
+#endif
+        }
+        case NodeType::NODE48: {
+            auto n = static_cast<const Node48*>(node);
+            auto index = n->childIndex[byte];
+            return index ? &n->children[index - 1] : nullptr;
+        }
+        case NodeType::NODE256: {
+            auto n = static_cast<const Node256*>(node);
+            return n->children[byte].empty() ? nullptr : &n->children[byte];
+        }
+    }
+
+    throw std::runtime_error("Unknown node type");
+}
+
+template<class V>
+void AdaptiveRadixTree<V>::addChild(Ref &slot, uint8_t byte, Ref child) {
+    auto node = slot.node();
+    switch (node->type) {
+        case NodeType::NODE4: {
+            auto n = static_cast<Node4*>(node);
+            if (n->numChildren < 4){
+                int pos = n->numChildren;
+                while (pos > 0 && n->keys[pos - 1] > byte){
+                    n->keys[pos] = n->keys[pos - 1];
+                    n->children[pos] = n->children[pos - 1];
+                    pos--;
+                }
+                n->keys[pos] = byte;
+                n->children[pos] = child;
+                n->numChildren++;
+                return;
+            }
+
+            auto larger = newNode<Node16>();
+            moveHeader(n, larger);
+            std::memcpy(larger->keys, n->keys, sizeof(n->keys));
+            std::copy(std::begin(n->children), std::end(n->children), larger->children);
+            freeNode(n);
+            slot = larger;
+            break;
+        }
+        case NodeType::NODE16: {
+            auto n = static_cast<Node16*>(node);
+            if (n->numChildren < 16){
+                int pos = n->numChildren;
+                while (pos > 0 && n->keys[pos - 1] > byte){
+                    n->keys[pos] = n->keys[pos - 1];
+                    n->children[pos] = n->children[pos - 1];
+                    pos--;
+                }
+                n->keys[pos] = byte;
+                n->children[pos] = child;
+                n->numChildren++;
+                return;
+            }
+
+            auto larger = newNode<Node48>();
+            moveHeader(n, larger);
+            for (int i = 0; i < 16; i++){
+                larger->childIndex[n->keys[i]] = i + 1;
+                larger->children[i] = n->children[i];
+            }
+            freeNode(n);
+            slot = larger;
+            break;
+        }
+        case NodeType::NODE48: {
+            auto n = static_cast<Node48*>(node);
+            if (n->numChildren < 48){
+                // Removals leave holes, so the first free position is not necessarily numChildren
+                int pos = 0;
+                while (!n->children[pos].empty()){
+                    pos++;
+                }
+                n->children[pos] = child;
+                n->childIndex[byte] = pos + 1;
+                n->numChildren++;
+                return;
+            }
+
+            auto larger = newNode<Node256>();
+            moveHeader(n, larger);
+            for (int b = 0; b < 256; b++){
+                if (n->childIndex[b]){
+                    larger->children[b] = n->children[n->childIndex[b] - 1];
+                }
+            }
+            freeNode(n);
+            slot = larger;
+            break;
+        }
+        case NodeType::NODE256: {
+            auto n = static_cast<Node256*>(node);
+            n->children[byte] = child;
+            n->numChildren++;
+            return;
+        }
+    }
+
+    addChild(slot, byte, child);
+}
+
+template<class V>
+void AdaptiveRadixTree<V>::removeChild(Ref &slot, uint8_t byte) {
+    auto node = slot.node();
+    switch (node->type) {
+        case NodeType::NODE4:
+        case NodeType::NODE16: {
+            auto keys = node->type == NodeType::NODE4 ? static_cast<Node4*>(node)->keys : static_cast<Node16*>(node)->keys;
+            auto children = node->type == NodeType::NODE4 ? static_cast<Node4*>(node)->children : static_cast<Node16*>(node)->children;
+            int pos = 0;
+            while (keys[pos] != byte){
+                pos++;
+            }
+            for (int i = pos + 1; i < node->numChildren; i++){
+                keys[i - 1] = keys[i];
+                children[i - 1] = children[i];
+            }
+            children[node->numChildren - 1] = Ref();
+            break;
+        }
+        case NodeType::NODE48: {
+            auto n = static_cast<Node48*>(node);
+            n->children[n->childIndex[byte] - 1] = Ref();
+            n->childIndex[byte] = 0;
+            break;
+        }
+        case NodeType::NODE256: {
+            static_cast<Node256*>(node)->children[byte] = Ref();
+            break;
+        }
+    }
+
+    node->numChildren--;
+    shrink(slot);
+}
+
+template<class V>
+void AdaptiveRadixTree<V>::shrink(Ref &slot) {
+    auto node = slot.node();
+    switch (node->type) {
+        case NodeType::NODE4: {
+            auto n = static_cast<Node4*>(node);
+            if (n->numChildren == 0){
+                slot = n->terminal ? Ref(n->terminal) : Ref();
+                n->terminal = nullptr;
+                freeNode(n);
+            } else if (n->numChildren == 1 && !n->terminal){
+                // Path compression: merge the node into its only child
+                auto child = n->children[0];
+                if (!child.isLeaf()){
+                    child.node()->prefix = n->prefix + static_cast<char>(n->keys[0]) + child.node()->prefix;
+                }
+                slot = child;
+                freeNode(n);
+            }
+            return;
+        }
+        case NodeType::NODE16: {
+            auto n = static_cast<Node16*>(node);
+            if (n->numChildren > 3){
+                return;
+            }
+
+            auto smaller = newNode<Node4>();
+            moveHeader(n, smaller);
+            std::memcpy(smaller->keys, n->keys, n->numChildren);
+            std::copy(n->children, n->children + n->numChildren, smaller->children);
+            freeNode(n);
+            slot = smaller;
+            return;
+        }
+        case NodeType::NODE48: {
+            auto n = static_cast<Node48*>(node);
+            if (n->numChildren > 12){
+                return;
+            }
+
+            auto smaller = newNode<Node16>();
+            moveHeader(n, smaller);
+            int pos = 0;
+            for (int b = 0; b < 256; b++){
+                if (n->childIndex[b]){
+                    smaller->keys[pos] = b;
+                    smaller->children[pos] = n->children[n->childIndex[b] - 1];
+                    pos++;
+                }
+            }
+            freeNode(n);
+            slot = smaller;
+            return;
+        }
+        case NodeType::NODE256: {
+            auto n = static_cast<Node256*>(node);
+            if (n->numChildren > 37){
+                return;
+            }
+
+            auto smaller = newNode<Node48>();
+            moveHeader(n, smaller);
+            int pos = 0;
+            for (int b = 0; b < 256; b++){
+                if (!n->children[b].empty()){
+                    smaller->childIndex[b] = pos + 1;
+                    smaller->children[pos] = n->children[b];
+                    pos++;
+                }
+            }
+            freeNode(n);
+            slot = smaller;
+            return;
+        }
+    }
+}
+
+template<class V>
+void AdaptiveRadixTree<V>::placeLeaf(Node4 *node, Leaf *leaf, size_t depth) {
+    if (leaf->key.size() == depth){
+        node->terminal = leaf;
+        return;
+    }
+
+    Ref slot(static_cast<Node*>(node));
+    addChild(slot, static_cast<uint8_t>(leaf->key[depth]), leaf);
+}
+
+template<class V>
+void AdaptiveRadixTree<V>::moveHeader(Node *from, Node *to) {
+    to->numChildren = from->numChildren;
+    to->prefix = std::move(from->prefix);
+    to->terminal = from->terminal;
+    from->terminal = nullptr;
+}
+
+template<class V>
+void AdaptiveRadixTree<V>::forEachChild(const Node *node, const std::function<void(uint8_t, Ref)> &callback) {
+    switch (node->type) {
+        case NodeType::NODE4: {
+            auto n = static_cast<const Node4*>(node);
+            for (int i = 0; i < n->numChildren; i++){
+                callback(n->keys[i], n->children[i]);
+            }
+            return;
+        }
+        case NodeType::NODE16: {
+            auto n = static_cast<const Node16*>(node);
+            for (int i = 0; i < n->numChildren; i++){
+                callback(n->keys[i], n->children[i]);
+            }
+            return;
+        }
+        case NodeType::NODE48: {
+            auto n = static_cast<const Node48*>(node);
+            for (int b = 0; b < 256; b++){
+                if (n->childIndex[b]){
+                    callback(b, n->children[n->childIndex[b] - 1]);
+                }
+            }
+            return;
+        }
+        case NodeType::NODE256: {
+            auto n = static_cast<const Node256*>(node);
+            for (int b = 0; b < 256; b++){
+                if (!n->children[b].empty()){
+                    callback(b, n->children[b]);
+                }
+            }
+            return;
+        }
+    }
+}
+
+template<class V>
+std::optional<std::pair<int, typename AdaptiveRadixTree<V>::Ref>> AdaptiveRadixTree<V>::childAtOrAfter(const Node *node, int byte) {
+    switch (node->type) {
+        case NodeType::NODE4: {
+            auto n = static_cast<const Node4*>(node);
+            for (int i = 0; i < n->numChildren; i++){
+                if (n->keys[i] >= byte){
+                    return std::make_pair(static_cast<int>(n->keys[i]), n->children[i]);
+                }
+            }
+            return std::nullopt;
+        }
+        case NodeType::NODE16: {
+            auto n = static_cast<const Node16*>(node);
+            for (int i = 0; i < n->numChildren; i++){
+                if (n->keys[i] >= byte){
+                    return std::make_pair(static_cast<int>(n->keys[i]), n->children[i]);
+                }
+            }
+            return std::nullopt;
+        }
+        case NodeType::NODE48: {
+            auto n = static_cast<const Node48*>(node);
+            for (int b = byte; b < 256; b++){
+                if (n->childIndex[b]){
+                    return std::make_pair(b, n->children[n->childIndex[b] - 1]);
+                }
+            }
+            return std::nullopt;
+        }
+        case NodeType::NODE256: {
+            auto n = static_cast<const Node256*>(node);
+            for (int b = byte; b < 256; b++){
+                if (!n->children[b].empty()){
+                    return std::make_pair(b, n->children[b]);
+                }
+            }
+            return std::nullopt;
+        }
+    }
+
+    return std::nullopt;
+}
+
+template<class V>
+void AdaptiveRadixTree<V>::traverse(Ref ref, const std::function<void(const std::string &, const V &)> &callback) {
+    if (ref.empty()){
+        return;
+    }
+
+    if (ref.isLeaf()){
+        callback(ref.leaf()->key, ref.leaf()->value);
+        return;
+    }
+
+    // A key ending at this node is a prefix of, and so sorts before, every key below it
+    auto node = ref.node();
+    if (node->terminal){
+        callback(node->terminal->key, node->terminal->value);
+    }
+    forEachChild(node, [&callback](uint8_t, Ref child){
+        traverse(child, callback);
+    });
+}
+
+template<class V>
+typename AdaptiveRadixTree<V>::Leaf* AdaptiveRadixTree<V>::newLeaf(const std::string &k, const V &v) {
+    bytes += sizeof(Leaf) + approximateHeapSize(k) + approximateHeapSize(v);
+    return new Leaf(k, v);
+}
+
+template<class V>
+void AdaptiveRadixTree<V>::freeLeaf(Leaf *leaf) {
+    bytes -= sizeof(Leaf) + approximateHeapSize(leaf->key) + approximateHeapSize(leaf->value);
+    delete leaf;
+}
+
+template<class V>
+template<class T>
+T* AdaptiveRadixTree<V>::newNode() {
+    bytes += sizeof(T);
+    return new T();
+}
+
+template<class V>
+void AdaptiveRadixTree<V>::freeNode(Node *node) {
+    bytes -= nodeSize(node->type);
+    deleteNode(node);
+}
+
+template<class V>
+size_t AdaptiveRadixTree<V>::nodeSize(NodeType type) {
+    switch (type) {
+        case NodeType::NODE4: return sizeof(Node4);
+        case NodeType::NODE16: return sizeof(Node16);
+        case NodeType::NODE48: return sizeof(Node48);
+        case NodeType::NODE256: return sizeof(Node256);
+    }
+
+    return 0;
+}
+
+template<class V>
+void AdaptiveRadixTree<V>::deleteNode(Node *node) {
+    switch (node->type) {
+        case NodeType::NODE4: delete static_cast<Node4*>(node); return;
+        case NodeType::NODE16: delete static_cast<Node16*>(node); return;
+        case NodeType::NODE48: delete static_cast<Node48*>(node); return;
+        case NodeType::NODE256: delete static_cast<Node256*>(node); return;
+    }
+}
+
+template<class V>
+void AdaptiveRadixTree<V>::deleteRecursive(Ref ref) {
+    if (ref.empty()){
+        return;
+    }
+
+    if (ref.isLeaf()){
+        delete ref.leaf();
+        return;
+    }
+
+    auto node = ref.node();
+    delete node->terminal;
+    forEachChild(node, [](uint8_t, Ref child){
+        deleteRecursive(child);
+    });
+    deleteNode(node);
+}
+
+#endif
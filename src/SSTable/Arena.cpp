@@ -0,0 +1,61 @@
+#include "Arena.h"
+
+Arena::Block::Block(size_t size) : data(new char[size]), size(size), used(0) {}
+
+Arena::Arena(size_t blockSize) : blockSize(blockSize), current(nullptr), totalSize(0) {
+    current.store(addBlock(blockSize), std::memory_order_release);
+}
+
+void* Arena::allocate(size_t bytes, size_t alignment) {
+    // Allocations much larger than usual get a block of their own, so they don't waste the rest of the current one
+    if (bytes > blockSize / 4){
+        std::lock_guard<std::mutex> lock(blocksMutex);
+        return alignedAllocation(addBlock(bytes + alignment), bytes, alignment);
+    }
+
+    while (true){
+        auto block = current.load(std::memory_order_acquire);
+        auto allocation = alignedAllocation(block, bytes, alignment);
+        if (allocation){
+            return allocation;
+        }
+
+        std::lock_guard<std::mutex> lock(blocksMutex);
+        // Another thread may have replaced the block while we waited for the lock
+        if (current.load(std::memory_order_acquire) == block){
+            current.store(addBlock(blockSize), std::memory_order_release);
+        }
+    }
+}
+
+void Arena::reset() {
+    std::lock_guard<std::mutex> lock(blocksMutex);
+    // The first block is always blockSize long. Keeping it means a refilled arena does not go back to malloc.
+    blocks.resize(1);
+    blocks.front()->used = 0;
+    totalSize = blockSize;
+    current.store(blocks.front().get(), std::memory_order_release);
+}
+
+size_t Arena::memoryUsage() const {
+    return totalSize.load(std::memory_order_relaxed);
+}
+
+Arena::Block* Arena::addBlock(size_t size) {
+    blocks.push_back(std::make_unique<Block>(size));
+    totalSize += size;
+    return blocks.back().get();
+}
+
+void* Arena::alignedAllocation(Block *block, size_t bytes, size_t alignment) {
+    // Reserve enough to align the start of the allocation, wherever the reservation ends up
+    auto reserved = bytes + alignment - 1;
+    auto start = block->used.fetch_add(reserved, std::memory_order_relaxed);
+    if (start + reserved > block->size){
+        return nullptr;
+    }
+
+    auto address = reinterpret_cast<uintptr_t>(block->data.get() + start);
+    auto aligned = (address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    return reinterpret_cast<void*>(aligned);
+}
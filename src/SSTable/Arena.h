@@ -0,0 +1,54 @@
+#ifndef DATAINTENSIVE_ARENA_H
+#define DATAINTENSIVE_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "SSTableParams.h"
+
+/*
+ * Bump allocator that hands out memory from large blocks. Memory is never freed individually, all of it is
+ * released at once by reset() or when the arena is destroyed. Objects with non-trivial destructors placed in
+ * the arena must be destroyed by their owner.
+ *
+ * allocate() is thread safe. Threads bump an atomic offset in the current block, and only take a lock when
+ * the block is full and a new one has to be allocated.
+ */
+class Arena {
+public:
+    explicit Arena(size_t blockSize = SSTable::arenaBlockSize);
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+    /*
+     * Releases every block but the first, which is reused. Must not be called while other threads are allocating.
+     */
+    void reset();
+    /*
+     * Total size of the blocks held by the arena
+     */
+    size_t memoryUsage() const;
+
+private:
+    struct Block {
+        explicit Block(size_t size);
+
+        std::unique_ptr<char[]> data;
+        size_t size;
+        std::atomic<size_t> used;
+    };
+
+    size_t blockSize;
+    std::atomic<Block*> current;
+    std::atomic<size_t> totalSize;
+    std::mutex blocksMutex;
+    std::vector<std::unique_ptr<Block>> blocks;
+
+    Block* addBlock(size_t size);
+    static void* alignedAllocation(Block *block, size_t bytes, size_t alignment);
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include "ArenaMemCache.h"
+#include <cstring>
+#include <stdexcept>
+
+class ArenaMemCache::SortedCursor : public Cursor {
+public:
+    explicit SortedCursor(const Node *first) : node(first) {
+        decode();
+    };
+    bool valid() const override { return node; }
+    const std::string& key() const override { return currentKey; }
+    const DbValue& value() const override { return currentValue; }
+    void next() override {
+        node = node->next[0];
+        decode();
+    }
+
+private:
+    const Node *node;
+    std::string currentKey;
+    DbValue currentValue;
+
+    void decode(){
+        if (node){
+            currentKey.assign(node->key, node->keyLength);
+            currentValue = decodeValue(node);
+        }
+    }
+};
+
+ArenaMemCache::ArenaMemCache(size_t blockSize) : arena(blockSize), head(nullptr), height(1), numEntries(0) {
+    head = newNode({}, maxHeight);
+}
+
+std::optional<DbValue> ArenaMemCache::get(const std::string &k) const {
+    auto node = findGreaterOrEqual(k, nullptr);
+    if (node && node->keyView() == k){
+        return decodeValue(node);
+    }
+
+    return std::nullopt;
+}
+
+void ArenaMemCache::insert(const std::string &k, const DbValue &v) {
+    Node *predecessors[maxHeight];
+    auto node = findGreaterOrEqual(k, predecessors);
+    if (node && node->keyView() == k){
+        // The old value stays in the arena until the next clear
+        setValue(node, v);
+        return;
+    }
+
+    auto nodeHeight = randomHeight();
+    for (int level = height; level < nodeHeight; level++){
+        predecessors[level] = head;
+    }
+    height = std::max(height, nodeHeight);
+
+    node = newNode(k, nodeHeight);
+    setValue(node, v);
+    for (int level = 0; level < nodeHeight; level++){
+        node->next[level] = predecessors[level]->next[level];
+        predecessors[level]->next[level] = node;
+    }
+    numEntries++;
+}
+
+bool ArenaMemCache::remove(const std::string &key) {
+    Node *predecessors[maxHeight];
+    auto node = findGreaterOrEqual(key, predecessors);
+    if (!node || node->keyView() != key){
+        return false;
+    }
+
+    for (int level = 0; level < node->height; level++){
+        predecessors[level]->next[level] = node->next[level];
+    }
+    numEntries--;
+    return true;
+}
+
+void ArenaMemCache::traverseSorted(const std::function<void(const std::string &, const DbValue &)> &callback) const {
+    for (auto node = head->next[0]; node; node = node->next[0]){
+        callback(std::string(node->keyView()), decodeValue(node));
+    }
+}
+
+std::unique_ptr<ArenaMemCache::Cursor> ArenaMemCache::newCursor() const {
+    return std::make_unique<SortedCursor>(head->next[0]);
+}
+
+size_t ArenaMemCache::size() const {
+    return numEntries;
+}
+
+void ArenaMemCache::clear() {
+    arena.reset();
+    height = 1;
+    numEntries = 0;
+    head = newNode({}, maxHeight);
+}
+
+size_t ArenaMemCache::memoryUsage() const {
+    return arena.memoryUsage();
+}
+
+std::string_view ArenaMemCache::Node::keyView() const {
+    return {key, keyLength};
+}
+
+ArenaMemCache::Node *ArenaMemCache::findGreaterOrEqual(std::string_view key, Node **predecessors) const {
+    auto curr = head;
+    for (int level = height - 1; level >= 0; level--){
+        while (curr->next[level] && curr->next[level]->keyView() < key){
+            curr = curr->next[level];
+        }
+        if (predecessors){
+            predecessors[level] = curr;
+        }
+    }
+
+    return curr->next[0];
+}
+
+ArenaMemCache::Node *ArenaMemCache::newNode(std::string_view key, int nodeHeight) {
+    auto bytes = sizeof(Node) + (nodeHeight - 1) * sizeof(Node*);
+    auto node = static_cast<Node*>(arena.allocate(bytes, alignof(Node)));
+    node->key = copyToArena(key.data(), key.size());
+    node->keyLength = key.size();
+    node->value = nullptr;
+    node->valueLength = 0;
+    node->typeIndex = 0;
+    node->height = nodeHeight;
+    std::fill(node->next, node->next + nodeHeight, nullptr);
+    return node;
+}
+
+void ArenaMemCache::setValue(Node *node, const DbValue &value) {
+    node->typeIndex = value.index();
+    // Every alternative but strings is trivially copyable, so its bytes can be copied as they are
+    std::visit([this, node](const auto &v){
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, std::string>){
+            node->value = copyToArena(v.data(), v.size());
+            node->valueLength = v.size();
+        } else {
+            node->value = copyToArena(reinterpret_cast<const char*>(&v), sizeof(T));
+            node->valueLength = sizeof(T);
+        }
+    }, value);
+}
+
+const char *ArenaMemCache::copyToArena(const char *data, size_t length) {
+    auto copy = static_cast<char*>(arena.allocate(length, 1));
+    std::memcpy(copy, data, length);
+    return copy;
+}
+
+DbValue ArenaMemCache::decodeValue(const Node *node) {
+    auto read = [node](auto v){
+        std::memcpy(&v, node->value, sizeof(v));
+        return DbValue(v);
+    };
+
+    switch (node->typeIndex) {
+        case intType: return read(int{});
+        case longType: return read(long{});
+        case doubleType: return read(double{});
+        case boolType: return read(bool{});
+        case stringType: return std::string(node->value, node->valueLength);
+        default: throw std::runtime_error("Invalid type index " + std::to_string(node->typeIndex));
+    }
+}
+
+int ArenaMemCache::randomHeight() {
+    int nodeHeight = 1;
+    while (nodeHeight < maxHeight && randomEngine() % branching == 0){
+        nodeHeight++;
+    }
+    return nodeHeight;
+}
@@ -0,0 +1,76 @@
+#ifndef DATAINTENSIVE_ARENAMEMCACHE_H
+#define DATAINTENSIVE_ARENAMEMCACHE_H
+
+#include <random>
+#include <string_view>
+#include "DbMemCache.h"
+#include "Arena.h"
+
+/*
+ * Skiplist memcache that keeps nodes, keys and values in an Arena. Values are stored as raw bytes rather than
+ * DbValue objects, so nothing in the arena needs a destructor: clear() releases everything at once instead
+ * of freeing entries one by one, and inserts never call malloc once the arena has grown to the size of a full
+ * memcache.
+ *
+ * Memory of overwritten values and removed entries is only reclaimed by clear(), which SSTableDb calls after
+ * every flush. Not thread safe, see ConcurrentSkipList for that.
+ */
+class ArenaMemCache : public DbMemCache {
+public:
+
+    explicit ArenaMemCache(size_t blockSize = SSTable::arenaBlockSize);
+    ArenaMemCache(const ArenaMemCache&) = delete;
+    ArenaMemCache& operator=(const ArenaMemCache&) = delete;
+    std::optional<DbValue> get(const std::string& k) const override;
+    void insert(const std::string& k, const DbValue& v) override;
+    bool remove(const std::string& key) override;
+    void traverseSorted(const std::function<void(const std::string& k, const DbValue& v)>& callback) const override;
+    /*
+     * The cursor decodes each entry into a std::string and DbValue it owns, since the arena holds raw bytes
+     */
+    std::unique_ptr<Cursor> newCursor() const override;
+    size_t size() const override;
+    void clear() override;
+    size_t memoryUsage() const override;
+
+private:
+
+    static constexpr int maxHeight = 12;
+    static constexpr unsigned int branching = 4;
+
+    struct Node {
+        const char *key;
+        const char *value;
+        uint32_t keyLength;
+        uint32_t valueLength;
+        DbValueTypeIndex typeIndex;
+        int height;
+        /*
+         * Actually height entries long, the node is allocated with room for the extra ones
+         */
+        Node *next[1];
+
+        std::string_view keyView() const;
+    };
+
+    class SortedCursor;
+
+    Arena arena;
+    Node *head;
+    int height;
+    size_t numEntries;
+    std::minstd_rand randomEngine;
+
+    /*
+     * First node with a key greater than or equal to key. If predecessors is given, it is filled with the last
+     * node before key at every level.
+     */
+    Node* findGreaterOrEqual(std::string_view key, Node **predecessors) const;
+    Node* newNode(std::string_view key, int nodeHeight);
+    void setValue(Node *node, const DbValue &value);
+    const char* copyToArena(const char *data, size_t length);
+    static DbValue decodeValue(const Node *node);
+    int randomHeight();
+};
+
+#endif
@@ -0,0 +1,390 @@
+#include "AsyncReader.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "SSTableParams.h"
+
+namespace {
+
+/*
+ * Threads shared by every THREAD_POOL reader, started the first time one is used
+ */
+class ReadThreadPool {
+public:
+    static ReadThreadPool& instance() {
+        static ReadThreadPool pool(SSTable::readThreads);
+        return pool;
+    }
+
+    ~ReadThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        available.notify_all();
+        for (auto &worker : workers){
+            worker.join();
+        }
+    }
+
+    void readAll(int fd, std::vector<AsyncReader::Read> &reads) {
+        struct Batch {
+            std::mutex mutex;
+            std::condition_variable done;
+            size_t remaining;
+            std::exception_ptr error;
+        } batch;
+        batch.remaining = reads.size();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto &read : reads){
+                tasks.emplace_back([fd, read, &batch](){
+                    std::exception_ptr error;
+                    try {
+                        AsyncReader::readFully(fd, read);
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+
+                    std::lock_guard<std::mutex> batchLock(batch.mutex);
+                    if (error && !batch.error){
+                        batch.error = error;
+                    }
+                    if (--batch.remaining == 0){
+                        batch.done.notify_one();
+                    }
+                });
+            }
+        }
+        available.notify_all();
+
+        std::unique_lock<std::mutex> lock(batch.mutex);
+        batch.done.wait(lock, [&batch](){ return batch.remaining == 0; });
+        if (batch.error){
+            std::rethrow_exception(batch.error);
+        }
+    }
+
+private:
+    explicit ReadThreadPool(size_t threads) {
+        for (size_t i = 0; i < threads; i++){
+            workers.emplace_back([this](){ work(); });
+        }
+    }
+
+    void work() {
+        while (true){
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                available.wait(lock, [this](){ return stopping || !tasks.empty(); });
+                if (tasks.empty()){
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<std::function<void()>> tasks;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+/*
+ * A submission and completion queue shared with the kernel, set up with the raw system calls so there is no
+ * dependency on liburing. Only used by the thread that created it.
+ */
+class IoUring {
+public:
+    explicit IoUring(unsigned int entries) {
+        io_uring_params params{};
+        ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ringFd < 0){
+            throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+        }
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMmap){
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED){
+            auto error = errno;
+            close(ringFd);
+            throw std::system_error(error, std::generic_category(), "mmap io_uring submission queue");
+        }
+        cqRing = singleMmap ? sqRing : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqesMap = cqRing == MAP_FAILED ? MAP_FAILED : mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (sqesMap == MAP_FAILED){
+            auto error = errno;
+            unmap();
+            throw std::system_error(error, std::generic_category(), "mmap io_uring queues");
+        }
+        sqes = static_cast<io_uring_sqe*>(sqesMap);
+
+        auto sq = static_cast<char*>(sqRing), cq = static_cast<char*>(cqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        depth = params.sq_entries;
+    }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    ~IoUring() {
+        munmap(sqes, sqesSize);
+        unmap();
+    }
+
+    void readAll(int fd, std::vector<AsyncReader::Read> &reads) {
+        // Reads that come back short are submitted again for the rest of their range
+        std::vector<AsyncReader::Read> progress(reads);
+        std::vector<iovec> iovecs(reads.size());
+        std::vector<size_t> retries;
+        size_t next = 0, inFlight = 0;
+        std::exception_ptr error;
+
+        while (inFlight > 0 || (!error && (next < reads.size() || !retries.empty()))){
+            while (!error && inFlight < depth && (next < reads.size() || !retries.empty())){
+                size_t i;
+                if (!retries.empty()){
+                    i = retries.back();
+                    retries.pop_back();
+                } else {
+                    i = next++;
+                }
+                queueRead(fd, i, progress[i], iovecs[i]);
+                inFlight++;
+            }
+
+            enter(1);
+            // Once a read failed, nothing new is queued, but reads already in flight still write into the
+            // caller's buffers and must complete before returning
+            auto head = *cqHead;
+            auto tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; head++){
+                const auto &cqe = cqes[head & *cqMask];
+                auto i = static_cast<size_t>(cqe.user_data);
+                inFlight--;
+                if (cqe.res < 0 && cqe.res != -EINTR && cqe.res != -EAGAIN){
+                    if (!error){
+                        error = std::make_exception_ptr(std::system_error(-cqe.res, std::generic_category(), "io_uring read at offset " + std::to_string(progress[i].pos)));
+                    }
+                    continue;
+                }
+                if (cqe.res == 0){
+                    if (!error){
+                        error = std::make_exception_ptr(std::runtime_error("Read past the end of the file at offset " + std::to_string(progress[i].pos)));
+                    }
+                    continue;
+                }
+
+                if (cqe.res > 0){
+                    progress[i].pos += cqe.res;
+                    progress[i].buffer += cqe.res;
+                    progress[i].length -= cqe.res;
+                }
+                if (progress[i].length > 0){
+                    retries.push_back(i);
+                }
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        }
+
+        if (error){
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    int ringFd = -1;
+    void *sqRing = MAP_FAILED;
+    void *cqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    io_uring_sqe *sqes = nullptr;
+    size_t sqesSize = 0;
+    unsigned *sqHead = nullptr, *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+    unsigned *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+    unsigned int depth = 0;
+
+    void queueRead(int fd, size_t i, const AsyncReader::Read &read, iovec &iov) {
+        iov = {read.buffer, read.length};
+        auto tail = *sqTail;
+        auto index = tail & *sqMask;
+        auto &sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(&iov);
+        sqe.len = 1;
+        sqe.off = read.pos;
+        sqe.user_data = i;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    /*
+     * Submits every queued read the kernel hasn't consumed yet and waits for at least minComplete completions
+     */
+    void enter(unsigned int minComplete) {
+        while (true){
+            auto toSubmit = *sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+            if (syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, IORING_ENTER_GETEVENTS, nullptr, 0) >= 0){
+                return;
+            }
+            if (errno != EINTR){
+                throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+            }
+        }
+    }
+
+    void unmap() {
+        if (cqRing != MAP_FAILED && cqRing != sqRing){
+            munmap(cqRing, cqRingSize);
+        }
+        if (sqRing != MAP_FAILED){
+            munmap(sqRing, sqRingSize);
+        }
+        close(ringFd);
+    }
+};
+
+/*
+ * Set once setting up a ring failed, for example because the kernel is too old or io_uring is blocked by a
+ * seccomp policy, so later readers go straight to the thread pool
+ */
+std::atomic<bool> ioUringUnavailable{false};
+
+/*
+ * Rings are per thread rather than per file, since a database can have many more files than threads
+ */
+IoUring* threadRing() {
+    thread_local std::unique_ptr<IoUring> ring;
+    if (!ring && !ioUringUnavailable.load(std::memory_order_relaxed)){
+        try {
+            ring = std::make_unique<IoUring>(SSTable::ioUringQueueDepth);
+        } catch (const std::system_error &) {
+            ioUringUnavailable.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    return ring.get();
+}
+
+class ThreadPoolReader : public AsyncReader {
+public:
+    explicit ThreadPoolReader(int fd) : AsyncReader(fd) {}
+
+    void readAll(std::vector<Read> &reads) override {
+        if (reads.size() == 1){
+            AsyncReader::readFully(fd, reads[0]);
+            return;
+        }
+        ReadThreadPool::instance().readAll(fd, reads);
+    }
+
+    ReadBackend backend() const override {
+        return ReadBackend::THREAD_POOL;
+    }
+};
+
+class IoUringReader : public AsyncReader {
+public:
+    explicit IoUringReader(int fd) : AsyncReader(fd) {}
+
+    void readAll(std::vector<Read> &reads) override {
+        if (reads.size() == 1){
+            AsyncReader::readFully(fd, reads[0]);
+            return;
+        }
+
+        auto ring = threadRing();
+        if (ring){
+            ring->readAll(fd, reads);
+        } else {
+            ReadThreadPool::instance().readAll(fd, reads);
+        }
+    }
+
+    ReadBackend backend() const override {
+        return threadRing() ? ReadBackend::IO_URING : ReadBackend::THREAD_POOL;
+    }
+};
+
+}
+
+std::unique_ptr<AsyncReader> AsyncReader::open(const std::filesystem::path &file, ReadBackend backend) {
+    if (backend == ReadBackend::SYNC){
+        return nullptr;
+    }
+
+    int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0){
+        throw std::system_error(errno, std::generic_category(), "Couldn't open " + file.string());
+    }
+
+    if (backend == ReadBackend::IO_URING){
+        return std::make_unique<IoUringReader>(fd);
+    }
+    return std::make_unique<ThreadPoolReader>(fd);
+}
+
+AsyncReader::AsyncReader(int fd) : fd(fd) {}
+
+void AsyncReader::readFully(int fd, const Read &read) {
+    auto remaining = read;
+    while (remaining.length > 0){
+        auto n = ::pread(fd, remaining.buffer, remaining.length, static_cast<off_t>(remaining.pos));
+        if (n < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "pread at offset " + std::to_string(remaining.pos));
+        }
+        if (n == 0){
+            throw std::runtime_error("Read past the end of the file at offset " + std::to_string(remaining.pos));
+        }
+
+        remaining.pos += n;
+        remaining.buffer += n;
+        remaining.length -= n;
+    }
+}
+
+AsyncReader::~AsyncReader() {
+    close(fd);
+}
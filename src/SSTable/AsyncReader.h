@@ -0,0 +1,69 @@
+#ifndef DATAINTENSIVE_ASYNCREADER_H
+#define DATAINTENSIVE_ASYNCREADER_H
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+/*
+ * How SSFiles read from disk when a lookup needs more than one read
+ */
+enum class ReadBackend : uint32_t {
+    /*
+     * One read at a time through the file's fstream
+     */
+    SYNC,
+    /*
+     * Batches are submitted to an io_uring, falling back to THREAD_POOL when io_uring is unavailable
+     */
+    IO_URING,
+    /*
+     * Batches are split across a pool of threads shared by every file, each issuing blocking preads
+     */
+    THREAD_POOL,
+};
+
+/*
+ * Reads many ranges of a file at once, so a batch of lookups keeps many reads in flight instead of waiting for
+ * each one before issuing the next. Readers only hold a file descriptor and never seek, so several threads may
+ * use the same reader.
+ */
+class AsyncReader {
+public:
+    struct Read {
+        uint64_t pos;
+        size_t length;
+        char *buffer;
+    };
+
+    /*
+     * Returns nullptr for ReadBackend::SYNC
+     */
+    static std::unique_ptr<AsyncReader> open(const std::filesystem::path &file, ReadBackend backend);
+    AsyncReader(const AsyncReader&) = delete;
+    AsyncReader& operator=(const AsyncReader&) = delete;
+    virtual ~AsyncReader();
+
+    /*
+     * Issues every read and returns once all of them completed. Throws if a read fails or reaches the end of
+     * the file before filling its buffer.
+     */
+    virtual void readAll(std::vector<Read> &reads) = 0;
+    /*
+     * Backend actually serving reads, which is THREAD_POOL for an io_uring reader once io_uring turned out to
+     * be unavailable
+     */
+    virtual ReadBackend backend() const = 0;
+    /*
+     * Blocking read of the whole range, retrying short reads. Throws like readAll.
+     */
+    static void readFully(int fd, const Read &read);
+
+protected:
+    explicit AsyncReader(int fd);
+    int fd;
+};
+
+
+#endif
@@ -3,17 +3,24 @@
 
 #include <functional>
 #include "MemCache.h"
+#include "HashIndex.hpp"
 
 template<class K, class V>
 class BST : public MemCache<K, V> {
 public:
 
-    BST();
+    /*
+     * With hashIndex, a HashIndex of every node is kept next to the tree, so get and inserts of existing keys don't
+     * walk the tree. Sorted iteration is unaffected.
+     */
+    explicit BST(bool hashIndex = false);
     std::optional<V> get(const K& k) const override;
     void insert(const K& k, const V& v) override;
     bool remove(const K& key) override;
     void traverseSorted(const std::function<void(const K& k, const V& v)>& callback) const override;
+    std::unique_ptr<typename MemCache<K, V>::Cursor> newCursor() const override;
     size_t size() const override;
+    size_t memoryUsage() const override;
     void clear() override;
     ~BST() override;
 
@@ -26,8 +33,40 @@ public:
 
 private:
 
+    /*
+     * In order traversal with an explicit stack, the top of the stack is the current node
+     */
+    class SortedCursor : public MemCache<K, V>::Cursor {
+    public:
+        explicit SortedCursor(Node *root) {
+            pushLeft(root);
+        };
+        bool valid() const override { return !nodes.empty(); }
+        const K& key() const override { return nodes.top()->key; }
+        const V& value() const override { return nodes.top()->value; }
+        void next() override {
+            auto curr = nodes.top();
+            nodes.pop();
+            pushLeft(curr->right);
+        }
+
+    private:
+        std::stack<Node*> nodes;
+
+        void pushLeft(Node *curr){
+            while (curr){
+                nodes.push(curr);
+                curr = curr->left;
+            }
+        }
+    };
+
     size_t treeSize;
+    size_t bytes;
     std::optional<Node*> root;
+    std::optional<HashIndex<K, Node>> index;
+    Node* newNode(const K& k, const V& v);
+    static size_t entrySize(const K& k, const V& v);
     Node* removeRecursive(Node* curr, const K& key);
     std::optional<Node*> findNode(const K& k) const;
     Node* findSuccessor(Node* node) const;
@@ -35,10 +74,19 @@ private:
 };
 
 template<class K, class V>
-BST<K, V>::BST() : treeSize(0), root(std::nullopt) {}
+BST<K, V>::BST(bool hashIndex) : treeSize(0), bytes(0), root(std::nullopt) {
+    if (hashIndex){
+        index.emplace();
+    }
+}
 
 template<class K, class V>
 std::optional<V> BST<K, V>::get(const K &k) const {
+    if (index.has_value()){
+        auto node = index->find(k);
+        return node ? std::optional<V>(node->value) : std::nullopt;
+    }
+
     auto node = findNode(k);
     if (node.has_value()){
         return node.value()->value;
@@ -49,28 +97,36 @@ std::optional<V> BST<K, V>::get(const K &k) const {
 
 template<class K, class V>
 void BST<K, V>::insert(const K &k, const V &v) {
+    if (index.has_value()){
+        if (auto node = index->find(k)){
+            bytes -= approximateHeapSize(node->value);
+            bytes += approximateHeapSize(v);
+            node->value = v;
+            return;
+        }
+    }
+
     if (!root.has_value()){
-        root = new Node(k, v);
-        treeSize++;
+        root = newNode(k, v);
         return;
     }
 
     auto curr = root.value();
     while (curr){
         if (k == curr->key){
+            bytes -= approximateHeapSize(curr->value);
+            bytes += approximateHeapSize(v);
             curr->value = v;
             return;
         } else if (k < curr->key){
             if (!curr->left){
-                curr->left = new Node(k, v);
-                treeSize++;
+                curr->left = newNode(k, v);
                 return;
             }
             curr = curr->left;
         } else {
             if (!curr->right){
-                curr->right = new Node(k, v);
-                treeSize++;
+                curr->right = newNode(k, v);
                 return;
             }
             curr = curr->right;
@@ -87,6 +143,16 @@ bool BST<K, V>::remove(const K &key) {
         return false;
     }
 
+    auto target = node.value();
+    bytes -= entrySize(target->key, target->value);
+    if (index.has_value()){
+        index->erase(key);
+        // A node with two children takes over its successor's key and value, and the successor's node is deleted
+        if (target->left && target->right){
+            index->insert(findSuccessor(target)->key, target);
+        }
+    }
+
     auto newRoot = removeRecursive(root.value(), key);
     treeSize--;
     if (newRoot){
@@ -120,11 +186,21 @@ void BST<K, V>::traverseSorted(const std::function<void(const K &, const V &)> &
     }
 }
 
+template<class K, class V>
+std::unique_ptr<typename MemCache<K, V>::Cursor> BST<K, V>::newCursor() const {
+    return std::make_unique<SortedCursor>(root.value_or(nullptr));
+}
+
 template<class K, class V>
 size_t BST<K, V>::size() const {
     return treeSize;
 }
 
+template<class K, class V>
+size_t BST<K, V>::memoryUsage() const {
+    return bytes + (index.has_value() ? index->memoryUsage() : 0);
+}
+
 template<class K, class V>
 typename BST<K,V>::Node *BST<K, V>::removeRecursive(BST::Node *curr, const K &key) {
     if (curr->key < key){
@@ -161,6 +237,10 @@ void BST<K, V>::clear() { //TODO
     }
 
     treeSize = 0;
+    bytes = 0;
+    if (index.has_value()){
+        index->clear();
+    }
     return clearRecursive(root.value());
 }
 
@@ -198,6 +278,21 @@ typename BST<K,V>::Node *BST<K, V>::findSuccessor(BST::Node *node) const {
     return curr;
 }
 
+template<class K, class V>
+typename BST<K,V>::Node *BST<K, V>::newNode(const K &k, const V &v) {
+    auto node = new Node(k, v);
+    treeSize++;
+    bytes += entrySize(k, v);
+    if (index.has_value()){
+        index->insert(k, node);
+    }
+    return node;
+}
+
+template<class K, class V>
+size_t BST<K, V>::entrySize(const K &k, const V &v) {
+    return sizeof(Node) + approximateHeapSize(k) + approximateHeapSize(v);
+}
 
 template<class K, class V>
 BST<K, V>::~BST() {
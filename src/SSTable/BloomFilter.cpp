@@ -4,22 +4,30 @@
 #include <utility>
 
 BloomFilter::BloomFilter(int numHashes, size_t numBits, const DbMemCache *memCache, const std::set<std::string> &tombstones) : numHashes(numHashes) {
-    bitset = std::vector<BloomFilter::ByteType>(numBits / sizeof(BloomFilter::ByteType), 0);
-    memCache->traverseSorted([this](const auto& key, const auto& value){
-       auto indices = getBitsetIndices(key);
-       for (auto index : indices){
-           setBit(index, true);
-       }
-    });
+    constexpr size_t bitsPerByte = 8 * sizeof(BloomFilter::ByteType);
+    bitset = std::vector<BloomFilter::ByteType>((numBits + bitsPerByte - 1) / bitsPerByte, 0);
+    for (const auto &entry : *memCache){
+        addKey(entry.key);
+    }
 
     for (const auto &key : tombstones){
-        auto indices = getBitsetIndices(key);
-        for (auto index : indices){
-            setBit(index, true);
-        }
+        addKey(key);
+    }
+}
+
+BloomFilter::BloomFilter(int numHashes, size_t numBits, const std::vector<std::string> &keys) : numHashes(numHashes) {
+    constexpr size_t bitsPerByte = 8 * sizeof(BloomFilter::ByteType);
+    bitset = std::vector<BloomFilter::ByteType>((numBits + bitsPerByte - 1) / bitsPerByte, 0);
+    for (const auto &key : keys){
+        addKey(key);
     }
 }
 
+BloomFilter::BloomFilter(int numHashes, size_t numBits) : numHashes(numHashes) {
+    constexpr size_t bitsPerByte = 8 * sizeof(BloomFilter::ByteType);
+    bitset = std::vector<BloomFilter::ByteType>((numBits + bitsPerByte - 1) / bitsPerByte, 0);
+}
+
 BloomFilter::BloomFilter(int numHashes, std::vector<BloomFilter::ByteType> bitset) : numHashes(numHashes), bitset(std::move(bitset)) {}
 
 bool BloomFilter::canContainKey(const std::string &key) const {
@@ -33,12 +41,22 @@ bool BloomFilter::canContainKey(const std::string &key) const {
     return true;
 }
 
+void BloomFilter::addKey(const std::string &key) {
+    addBitsetIndices(getBitsetIndices(key));
+}
+
+void BloomFilter::addBitsetIndices(const std::vector<unsigned long long> &indices) {
+    for (auto index : indices){
+        setBit(index, true);
+    }
+}
+
 std::vector<unsigned long long> BloomFilter::getBitsetIndices(const std::string &str) const {
     std::vector<unsigned long long int> indices;
     auto hashChunks = splitHash(sha256(str), numHashes);
     indices.reserve(hashChunks.size());
     for (auto chunk : hashChunks){
-        indices.push_back(chunk % bitset.size());
+        indices.push_back(chunk % numBits());
     }
 
     return indices;
@@ -81,29 +99,36 @@ std::vector<unsigned long long> BloomFilter::splitHash(const std::vector<BloomFi
     return chunks;
 }
 
+std::vector<BloomFilter::ByteType> BloomFilter::serialize() const {
+    return bitset;
+}
+
 std::vector<BloomFilter::ByteType> BloomFilter::getBitset() const {
     return bitset;
 }
 
+size_t BloomFilter::numBits() const {
+    return bitset.size() * 8;
+}
+
 void BloomFilter::setBit(size_t bit, bool set) {
-    if (bit / sizeof(BloomFilter::ByteType) >= bitset.size()){
+    if (bit >= numBits()){
         throw std::runtime_error("Bit too large");
     }
 
     if (set){
-        bitset[bit / sizeof(ByteType)] |= 1 << (bit % 8);
+        bitset[bit / 8] |= 1 << (bit % 8);
     } else {
-        bitset[bit / sizeof(ByteType)] &= ~(1 << (bit % 8));
+        bitset[bit / 8] &= ~(1 << (bit % 8));
     }
 }
 
 bool BloomFilter::testBit(size_t bit) const {
-    int byteSize = sizeof(decltype(bitset)::value_type);
-    if (bit / byteSize >= bitset.size()){
+    if (bit >= numBits()){
         throw std::runtime_error("Bit too large");
     }
 
-    return bitset[bit / byteSize] & (1 << (bit % 8));
+    return bitset[bit / 8] & (1 << (bit % 8));
 }
 
 
@@ -4,8 +4,9 @@
 #include <set>
 #include "SSTableParams.h"
 #include "DbMemCache.h"
+#include "KeyFilter.h"
 
-class BloomFilter {
+class BloomFilter : public KeyFilter {
 public:
     /*
      * We don't use std::byte since we want to perform bitwise operations. We expose this type since other
@@ -14,9 +15,22 @@ public:
     using ByteType = uint8_t;
 
     BloomFilter(int numHashes, size_t numBits, const DbMemCache* memCache, const std::set<std::string> &tombstones);
+    BloomFilter(int numHashes, size_t numBits, const std::vector<std::string> &keys);
+    /*
+     * Empty filter, keys are added one at a time with addKey
+     */
+    BloomFilter(int numHashes, size_t numBits);
     BloomFilter(int numHashes, std::vector<ByteType> bitset);
-    bool canContainKey(const std::string &key) const;
+    bool canContainKey(const std::string &key) const override;
+    std::vector<ByteType> serialize() const override;
     std::vector<ByteType> getBitset() const;
+    void addKey(const std::string &key);
+    /*
+     * Bits addKey sets for key. Only depends on the size of the filter, so it can be called from other threads
+     * while keys are being added, and the bits set later with addBitsetIndices.
+     */
+    std::vector<unsigned long long> getBitsetIndices(const std::string &str) const;
+    void addBitsetIndices(const std::vector<unsigned long long> &indices);
 
 private:
     int numHashes;
@@ -26,9 +40,9 @@ private:
      */
     std::vector<ByteType> bitset;
 
-    std::vector<unsigned long long> getBitsetIndices(const std::string &str) const;
     static std::vector<ByteType> sha256(const std::string& str);
     static std::vector<unsigned long long> splitHash(const std::vector<ByteType> &hash, int splits);
+    size_t numBits() const;
     void setBit(size_t bit, bool set);
     bool testBit(size_t bit) const;
 };
@@ -0,0 +1,317 @@
+#ifndef DATAINTENSIVE_BULKLOADMEMCACHE_HPP
+#define DATAINTENSIVE_BULKLOADMEMCACHE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "MemCache.h"
+#include "SSTableParams.h"
+
+/*
+ * Memcache for bulk loads, where writes dominate and reads are rare. insert and remove only append to a vector,
+ * which is sorted the next time it is read (get, size, traverseSorted or a cursor). Only the entries
+ * appended since the last read are sorted, split across threads when there are enough of them, and then merged
+ * into the entries that were already sorted. The last write to a key wins. A hash map remembers whether the last
+ * appended write to each key was an insert, so remove can tell whether the key existed without sorting.
+ *
+ * The sort never moves entries around. It sorts 16 byte records holding the first 8 bytes of each key and the
+ * entry's position, so most comparisons are between two integers, and the merge then moves every entry once.
+ *
+ * Reads rebuild the vector, so not even const calls may run concurrently. size() has to sort as well, so SSTableDb
+ * should flush this memcache by SSFileOptions::memcacheFlushBytes rather than by number of entries.
+ */
+template<class K, class V>
+class BulkLoadMemCache : public MemCache<K, V> {
+public:
+
+    /*
+     * sortThreads is the most threads a single sort uses
+     */
+    explicit BulkLoadMemCache(unsigned int sortThreads = std::thread::hardware_concurrency());
+    std::optional<V> get(const K& k) const override;
+    void insert(const K& k, const V& v) override;
+    bool remove(const K& key) override;
+    void traverseSorted(const std::function<void(const K& k, const V& v)>& callback) const override;
+    std::unique_ptr<typename MemCache<K, V>::Cursor> newCursor() const override;
+    size_t size() const override;
+    size_t memoryUsage() const override;
+    /*
+     * Keeps the vector's capacity, so the next load does not grow it again
+     */
+    void clear() override;
+    /*
+     * The number of threads the last sort used, 0 before anything was sorted
+     */
+    unsigned int lastSortThreads() const;
+
+private:
+
+    struct Entry {
+        K key;
+        /*
+         * Empty for a remove
+         */
+        std::optional<V> value;
+    };
+
+    /*
+     * An appended entry, ordered by key and then by position so the last write to a key comes last
+     */
+    struct SortRecord {
+        uint64_t keyPrefix;
+        size_t position;
+    };
+
+    using RecordIterator = typename std::vector<SortRecord>::iterator;
+
+    class SortedCursor : public MemCache<K, V>::Cursor {
+    public:
+        explicit SortedCursor(const std::vector<Entry> &entries) : entries(entries) {};
+        bool valid() const override { return pos < entries.size(); }
+        void next() override { pos++; }
+        const K& key() const override { return entries[pos].key; }
+        const V& value() const override { return entries[pos].value.value(); }
+
+    private:
+        const std::vector<Entry> &entries;
+        size_t pos = 0;
+    };
+
+    /*
+     * Entries before sortedEnd are sorted by key, hold one live entry per key, and are older than every entry
+     * after sortedEnd
+     */
+    mutable std::vector<Entry> entries;
+    mutable size_t sortedEnd = 0;
+    mutable size_t heapBytes = 0;
+    /*
+     * Whether the last write to each key appended since the last sort was an insert
+     */
+    mutable std::unordered_map<K, bool> appendedLive;
+    unsigned int sortThreads;
+    mutable unsigned int lastSortThreadCount = 0;
+
+    void sortAppended() const;
+    void parallelSort(RecordIterator begin, RecordIterator end) const;
+    bool recordLess(const SortRecord &lhs, const SortRecord &rhs) const;
+    /*
+     * Big endian, so prefixes compare like the keys they come from. Keys other than strings all get the same
+     * prefix and are compared in full.
+     */
+    static uint64_t keyPrefix(const std::string &key);
+    template<class T>
+    static uint64_t keyPrefix(const T &key);
+};
+
+template<class K, class V>
+BulkLoadMemCache<K, V>::BulkLoadMemCache(unsigned int sortThreads) : sortThreads(std::max(1u, sortThreads)) {}
+
+template<class K, class V>
+std::optional<V> BulkLoadMemCache<K, V>::get(const K &k) const {
+    sortAppended();
+    auto it = std::lower_bound(entries.begin(), entries.end(), k, [](const Entry &entry, const K &key){
+        return entry.key < key;
+    });
+    if (it == entries.end() || it->key != k){
+        return std::nullopt;
+    }
+
+    return it->value;
+}
+
+template<class K, class V>
+void BulkLoadMemCache<K, V>::insert(const K &k, const V &v) {
+    entries.push_back({k, v});
+    heapBytes += approximateHeapSize(k) + approximateHeapSize(v);
+    appendedLive[k] = true;
+}
+
+template<class K, class V>
+bool BulkLoadMemCache<K, V>::remove(const K &key) {
+    bool existed;
+    auto appended = appendedLive.find(key);
+    if (appended != appendedLive.end()){
+        existed = appended->second;
+        appended->second = false;
+    } else {
+        // Nothing after sortedEnd wrote the key, so the sorted entries hold its last write
+        auto it = std::lower_bound(entries.begin(), entries.begin() + sortedEnd, key, [](const Entry &entry, const K &k){
+            return entry.key < k;
+        });
+        existed = it != entries.begin() + sortedEnd && it->key == key;
+        appendedLive.emplace(key, false);
+    }
+
+    entries.push_back({key, std::nullopt});
+    heapBytes += approximateHeapSize(key);
+    return existed;
+}
+
+template<class K, class V>
+void BulkLoadMemCache<K, V>::traverseSorted(const std::function<void(const K &, const V &)> &callback) const {
+    sortAppended();
+    for (const auto &entry : entries){
+        callback(entry.key, entry.value.value());
+    }
+}
+
+template<class K, class V>
+std::unique_ptr<typename MemCache<K, V>::Cursor> BulkLoadMemCache<K, V>::newCursor() const {
+    sortAppended();
+    return std::make_unique<SortedCursor>(entries);
+}
+
+template<class K, class V>
+size_t BulkLoadMemCache<K, V>::size() const {
+    sortAppended();
+    return entries.size();
+}
+
+template<class K, class V>
+size_t BulkLoadMemCache<K, V>::memoryUsage() const {
+    // A hash map node holds the key, the flag and about two pointers
+    return entries.size() * sizeof(Entry) + heapBytes + appendedLive.size() * (sizeof(K) + 3 * sizeof(void*));
+}
+
+template<class K, class V>
+void BulkLoadMemCache<K, V>::clear() {
+    entries.clear();
+    appendedLive.clear();
+    sortedEnd = 0;
+    heapBytes = 0;
+}
+
+template<class K, class V>
+unsigned int BulkLoadMemCache<K, V>::lastSortThreads() const {
+    return lastSortThreadCount;
+}
+
+template<class K, class V>
+void BulkLoadMemCache<K, V>::sortAppended() const {
+    if (sortedEnd == entries.size()){
+        return;
+    }
+
+    std::vector<SortRecord> appended;
+    appended.reserve(entries.size() - sortedEnd);
+    for (auto pos = sortedEnd; pos < entries.size(); pos++){
+        appended.push_back({keyPrefix(entries[pos].key), pos});
+    }
+    parallelSort(appended.begin(), appended.end());
+
+    // Merge with the sorted entries, keeping the last write to every key and dropping keys whose last write was a remove
+    std::vector<Entry> merged;
+    merged.reserve(sortedEnd + appended.size());
+    heapBytes = 0;
+    auto keep = [this, &merged](Entry &entry){
+        if (entry.value.has_value()){
+            heapBytes += approximateHeapSize(entry.key) + approximateHeapSize(entry.value.value());
+            merged.push_back(std::move(entry));
+        }
+    };
+
+    size_t sortedPos = 0;
+    for (auto record = appended.begin(); record != appended.end();){
+        auto &first = entries[record->position];
+        for (; sortedPos < sortedEnd && entries[sortedPos].key < first.key; sortedPos++){
+            keep(entries[sortedPos]);
+        }
+        // An appended write replaces the sorted entry for the same key
+        if (sortedPos < sortedEnd && entries[sortedPos].key == first.key){
+            sortedPos++;
+        }
+
+        auto last = record;
+        while (++record != appended.end() && entries[record->position].key == first.key){
+            last = record;
+        }
+        keep(entries[last->position]);
+    }
+    for (; sortedPos < sortedEnd; sortedPos++){
+        keep(entries[sortedPos]);
+    }
+
+    entries.swap(merged);
+    sortedEnd = entries.size();
+    appendedLive.clear();
+}
+
+template<class K, class V>
+void BulkLoadMemCache<K, V>::parallelSort(RecordIterator begin, RecordIterator end) const {
+    auto less = [this](const SortRecord &lhs, const SortRecord &rhs){
+        return recordLess(lhs, rhs);
+    };
+    auto length = static_cast<size_t>(end - begin);
+    auto threads = std::min<size_t>(sortThreads, length / SSTable::parallelSortMinRun);
+    lastSortThreadCount = std::max<size_t>(1, threads);
+    if (threads <= 1){
+        std::sort(begin, end, less);
+        return;
+    }
+
+    // Sort one run per thread, then merge neighbouring runs in parallel until a single run is left
+    std::vector<RecordIterator> bounds;
+    for (size_t i = 0; i <= threads; i++){
+        bounds.push_back(begin + static_cast<std::ptrdiff_t>(length * i / threads));
+    }
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threads; i++){
+        workers.emplace_back([&bounds, &less, i](){
+            std::sort(bounds[i], bounds[i + 1], less);
+        });
+    }
+    for (auto &worker : workers){
+        worker.join();
+    }
+
+    for (size_t width = 1; width < threads; width *= 2){
+        workers.clear();
+        for (size_t i = 0; i + width < threads; i += 2 * width){
+            auto first = bounds[i], middle = bounds[i + width], last = bounds[std::min(i + 2 * width, threads)];
+            workers.emplace_back([first, middle, last, &less](){
+                std::inplace_merge(first, middle, last, less);
+            });
+        }
+        for (auto &worker : workers){
+            worker.join();
+        }
+    }
+}
+
+template<class K, class V>
+bool BulkLoadMemCache<K, V>::recordLess(const SortRecord &lhs, const SortRecord &rhs) const {
+    if (lhs.keyPrefix != rhs.keyPrefix){
+        return lhs.keyPrefix < rhs.keyPrefix;
+    }
+
+    const auto &lhsKey = entries[lhs.position].key, &rhsKey = entries[rhs.position].key;
+    if (lhsKey < rhsKey){
+        return true;
+    }
+    if (rhsKey < lhsKey){
+        return false;
+    }
+    return lhs.position < rhs.position;
+}
+
+template<class K, class V>
+uint64_t BulkLoadMemCache<K, V>::keyPrefix(const std::string &key) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < sizeof(prefix); i++){
+        prefix = (prefix << 8) | (i < key.size() ? static_cast<unsigned char>(key[i]) : 0);
+    }
+
+    return prefix;
+}
+
+template<class K, class V>
+template<class T>
+uint64_t BulkLoadMemCache<K, V>::keyPrefix(const T &key) {
+    return 0;
+}
+
+#endif
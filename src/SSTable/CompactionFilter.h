@@ -0,0 +1,31 @@
+#ifndef DATAINTENSIVE_COMPACTIONFILTER_H
+#define DATAINTENSIVE_COMPACTIONFILTER_H
+
+#include <string>
+#include "../DatabaseEntry.h"
+
+/*
+ * Lets entries be dropped or rewritten while the memcache is flushed and while SSFiles are compacted, so data that
+ * is no longer wanted goes away as part of work that happens anyway, instead of through a pass over the whole
+ * keyspace. Filters see every live entry that is written out, but not tombstones, expired entries nor merge
+ * operands. Compactions call the filter with the result of applying a key's operands.
+ */
+class CompactionFilter {
+public:
+    enum class Decision {
+        KEEP,
+        /*
+         * Flushes write a tombstone for the key, since older files may still hold it, and compactions leave it out
+         */
+        DROP,
+        /*
+         * The entry is written with newValue instead, keeping its expiry
+         */
+        REWRITE
+    };
+
+    virtual Decision filter(const std::string &key, const DbValue &value, DbValue &newValue) const = 0;
+    virtual ~CompactionFilter() = default;
+};
+
+#endif
@@ -0,0 +1,363 @@
+#ifndef DATAINTENSIVE_CONCURRENTSKIPLIST_HPP
+#define DATAINTENSIVE_CONCURRENTSKIPLIST_HPP
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <new>
+#include <random>
+#include "MemCache.h"
+#include "Arena.h"
+
+/*
+ * Skiplist that supports concurrent insert, get, remove and traverseSorted calls without locking. Nodes are
+ * linked with compare-and-swap, bottom level first, so a node is part of the list as soon as it is linked into
+ * the bottom level. Nodes and values are allocated from an Arena.
+ *
+ * Nodes are never unlinked. Each node holds a chain of value cells, newest first, and remove pushes a cell
+ * without a value. Replaced cells stay in the chain since a concurrent get may still be reading them, and are
+ * only destroyed by clear().
+ *
+ * clear() must not run concurrently with any other call.
+ */
+template<class K, class V>
+class ConcurrentSkipList : public MemCache<K, V> {
+public:
+
+    ConcurrentSkipList();
+    std::optional<V> get(const K& k) const override;
+    void insert(const K& k, const V& v) override;
+    bool remove(const K& key) override;
+    void traverseSorted(const std::function<void(const K& k, const V& v)>& callback) const override;
+    /*
+     * Safe to use while other threads insert and remove. Entries inserted after the cursor passed their
+     * position are not seen.
+     */
+    std::unique_ptr<typename MemCache<K, V>::Cursor> newCursor() const override;
+    size_t size() const override;
+    /*
+     * Includes replaced and removed values, which hold on to their memory until clear()
+     */
+    size_t memoryUsage() const override;
+    void clear() override;
+    ~ConcurrentSkipList() override;
+
+private:
+
+    static constexpr int maxHeight = 12;
+    /*
+     * Each level holds on average 1 / branching of the nodes of the level below
+     */
+    static constexpr unsigned int branching = 4;
+
+    struct ValueCell {
+        ValueCell(std::optional<V> value, ValueCell *previous) : value(std::move(value)), previous(previous) {};
+        std::optional<V> value;
+        ValueCell *previous;
+    };
+
+    struct Node {
+        Node(K key, int height) : key(std::move(key)), height(height), value(nullptr) {};
+        K key;
+        int height;
+        std::atomic<ValueCell*> value;
+        /*
+         * Actually height entries long, the node is allocated with room for the extra ones
+         */
+        std::atomic<Node*> next[1];
+    };
+
+    /*
+     * For every level, the last node with a key smaller than the searched key (nullptr for the head) and the
+     * node after it
+     */
+    struct Position {
+        std::array<Node*, maxHeight> predecessors;
+        std::array<Node*, maxHeight> successors;
+    };
+
+    /*
+     * Walks the bottom level, skipping removed entries
+     */
+    class SortedCursor : public MemCache<K, V>::Cursor {
+    public:
+        explicit SortedCursor(Node *first) : node(first) {
+            skipRemoved();
+        };
+        bool valid() const override { return node; }
+        const K& key() const override { return node->key; }
+        const V& value() const override { return *current; }
+        void next() override {
+            node = node->next[0].load(std::memory_order_acquire);
+            skipRemoved();
+        }
+
+    private:
+        Node *node;
+        const V *current = nullptr;
+
+        void skipRemoved(){
+            for (; node; node = node->next[0].load(std::memory_order_acquire)){
+                auto cell = node->value.load(std::memory_order_acquire);
+                if (cell && cell->value.has_value()){
+                    current = &cell->value.value();
+                    return;
+                }
+            }
+        }
+    };
+
+    Arena arena;
+    std::array<std::atomic<Node*>, maxHeight> head;
+    std::atomic<int> height;
+    std::atomic<size_t> listSize;
+    /*
+     * Memory owned by keys and values outside of the arena
+     */
+    std::atomic<size_t> heapBytes;
+
+    std::atomic<Node*>& nextOf(Node *node, int level);
+    const std::atomic<Node*>& nextOf(const Node *node, int level) const;
+    Node* findGreaterOrEqual(const K& key) const;
+    Position findPosition(const K& key);
+    /*
+     * Pushes a new value cell to the node. Returns whether the key was live before the call.
+     */
+    bool pushValue(Node *node, std::optional<V> value);
+    Node* newNode(const K& key, int nodeHeight);
+    void destroyNode(Node *node);
+    static int randomHeight();
+};
+
+template<class K, class V>
+ConcurrentSkipList<K, V>::ConcurrentSkipList() : height(1), listSize(0), heapBytes(0) {
+    for (auto &link : head){
+        link.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+template<class K, class V>
+std::optional<V> ConcurrentSkipList<K, V>::get(const K &k) const {
+    auto node = findGreaterOrEqual(k);
+    if (!node || node->key != k){
+        return std::nullopt;
+    }
+
+    auto cell = node->value.load(std::memory_order_acquire);
+    return cell ? cell->value : std::nullopt;
+}
+
+template<class K, class V>
+void ConcurrentSkipList<K, V>::insert(const K &k, const V &v) {
+    Node *node = nullptr;
+    int nodeHeight = 0;
+    while (true){
+        auto position = findPosition(k);
+        auto existing = position.successors[0];
+        if (existing && existing->key == k){
+            if (node){
+                // Another thread linked the key first, our node was never visible
+                heapBytes.fetch_sub(approximateHeapSize(k) + approximateHeapSize(v), std::memory_order_relaxed);
+                destroyNode(node);
+            }
+            if (!pushValue(existing, v)){
+                listSize.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+
+        if (!node){
+            nodeHeight = randomHeight();
+            node = newNode(k, nodeHeight);
+            node->value.store(new (arena.allocate(sizeof(ValueCell), alignof(ValueCell))) ValueCell(v, nullptr), std::memory_order_relaxed);
+            heapBytes.fetch_add(approximateHeapSize(v), std::memory_order_relaxed);
+        }
+
+        node->next[0].store(existing, std::memory_order_relaxed);
+        if (nextOf(position.predecessors[0], 0).compare_exchange_strong(existing, node, std::memory_order_release)){
+            listSize.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+    }
+
+    auto listHeight = height.load(std::memory_order_relaxed);
+    while (nodeHeight > listHeight && !height.compare_exchange_weak(listHeight, nodeHeight, std::memory_order_relaxed)){}
+
+    // The node is already in the list, the upper levels only make searches faster
+    for (int level = 1; level < nodeHeight; level++){
+        while (true){
+            auto position = findPosition(k);
+            auto successor = position.successors[level];
+            node->next[level].store(successor, std::memory_order_relaxed);
+            if (nextOf(position.predecessors[level], level).compare_exchange_strong(successor, node, std::memory_order_release)){
+                break;
+            }
+        }
+    }
+}
+
+template<class K, class V>
+bool ConcurrentSkipList<K, V>::remove(const K &key) {
+    auto node = findGreaterOrEqual(key);
+    if (!node || node->key != key){
+        return false;
+    }
+
+    auto cell = node->value.load(std::memory_order_acquire);
+    if (!cell || !cell->value.has_value()){
+        return false;
+    }
+
+    if (!pushValue(node, std::nullopt)){
+        // A concurrent remove won
+        return false;
+    }
+    listSize.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+template<class K, class V>
+void ConcurrentSkipList<K, V>::traverseSorted(const std::function<void(const K &, const V &)> &callback) const {
+    for (auto node = head[0].load(std::memory_order_acquire); node; node = node->next[0].load(std::memory_order_acquire)){
+        auto cell = node->value.load(std::memory_order_acquire);
+        if (cell && cell->value.has_value()){
+            callback(node->key, cell->value.value());
+        }
+    }
+}
+
+template<class K, class V>
+std::unique_ptr<typename MemCache<K, V>::Cursor> ConcurrentSkipList<K, V>::newCursor() const {
+    return std::make_unique<SortedCursor>(head[0].load(std::memory_order_acquire));
+}
+
+template<class K, class V>
+size_t ConcurrentSkipList<K, V>::size() const {
+    return listSize.load(std::memory_order_relaxed);
+}
+
+template<class K, class V>
+size_t ConcurrentSkipList<K, V>::memoryUsage() const {
+    return arena.memoryUsage() + heapBytes.load(std::memory_order_relaxed);
+}
+
+template<class K, class V>
+void ConcurrentSkipList<K, V>::clear() {
+    auto node = head[0].load(std::memory_order_acquire);
+    while (node){
+        auto next = node->next[0].load(std::memory_order_relaxed);
+        destroyNode(node);
+        node = next;
+    }
+
+    for (auto &link : head){
+        link.store(nullptr, std::memory_order_relaxed);
+    }
+    height = 1;
+    listSize = 0;
+    heapBytes = 0;
+    arena.reset();
+}
+
+template<class K, class V>
+ConcurrentSkipList<K, V>::~ConcurrentSkipList() {
+    clear();
+}
+
+template<class K, class V>
+std::atomic<typename ConcurrentSkipList<K, V>::Node*>& ConcurrentSkipList<K, V>::nextOf(Node *node, int level) {
+    return node ? node->next[level] : head[level];
+}
+
+template<class K, class V>
+const std::atomic<typename ConcurrentSkipList<K, V>::Node*>& ConcurrentSkipList<K, V>::nextOf(const Node *node, int level) const {
+    return node ? node->next[level] : head[level];
+}
+
+template<class K, class V>
+typename ConcurrentSkipList<K, V>::Node* ConcurrentSkipList<K, V>::findGreaterOrEqual(const K &key) const {
+    const Node *predecessor = nullptr;
+    Node *successor = nullptr;
+    for (int level = height.load(std::memory_order_relaxed) - 1; level >= 0; level--){
+        successor = nextOf(predecessor, level).load(std::memory_order_acquire);
+        while (successor && successor->key < key){
+            predecessor = successor;
+            successor = nextOf(predecessor, level).load(std::memory_order_acquire);
+        }
+    }
+
+    return successor;
+}
+
+template<class K, class V>
+typename ConcurrentSkipList<K, V>::Position ConcurrentSkipList<K, V>::findPosition(const K &key) {
+    Position position{};
+    Node *predecessor = nullptr;
+    for (int level = maxHeight - 1; level >= 0; level--){
+        auto successor = nextOf(predecessor, level).load(std::memory_order_acquire);
+        while (successor && successor->key < key){
+            predecessor = successor;
+            successor = nextOf(predecessor, level).load(std::memory_order_acquire);
+        }
+        position.predecessors[level] = predecessor;
+        position.successors[level] = successor;
+    }
+
+    return position;
+}
+
+template<class K, class V>
+bool ConcurrentSkipList<K, V>::pushValue(Node *node, std::optional<V> value) {
+    auto removing = !value.has_value();
+    auto valueBytes = removing ? 0 : approximateHeapSize(value.value());
+    auto cell = new (arena.allocate(sizeof(ValueCell), alignof(ValueCell))) ValueCell(std::move(value), nullptr);
+    auto previous = node->value.load(std::memory_order_acquire);
+    while (true){
+        auto wasLive = previous && previous->value.has_value();
+        if (removing && !wasLive){
+            // Nothing to remove. The cell is not linked anywhere, so destroy it here.
+            cell->~ValueCell();
+            return false;
+        }
+
+        cell->previous = previous;
+        if (node->value.compare_exchange_weak(previous, cell, std::memory_order_acq_rel)){
+            heapBytes.fetch_add(valueBytes, std::memory_order_relaxed);
+            return wasLive;
+        }
+    }
+}
+
+template<class K, class V>
+typename ConcurrentSkipList<K, V>::Node* ConcurrentSkipList<K, V>::newNode(const K &key, int nodeHeight) {
+    auto bytes = sizeof(Node) + (nodeHeight - 1) * sizeof(std::atomic<Node*>);
+    auto node = new (arena.allocate(bytes, alignof(Node))) Node(key, nodeHeight);
+    heapBytes.fetch_add(approximateHeapSize(key), std::memory_order_relaxed);
+    for (int level = 1; level < nodeHeight; level++){
+        new (&node->next[level]) std::atomic<Node*>(nullptr);
+    }
+    return node;
+}
+
+template<class K, class V>
+void ConcurrentSkipList<K, V>::destroyNode(Node *node) {
+    auto cell = node->value.load(std::memory_order_relaxed);
+    while (cell){
+        auto previous = cell->previous;
+        cell->~ValueCell();
+        cell = previous;
+    }
+    node->~Node();
+}
+
+template<class K, class V>
+int ConcurrentSkipList<K, V>::randomHeight() {
+    thread_local std::minstd_rand randomEngine(std::random_device{}());
+    int nodeHeight = 1;
+    while (nodeHeight < maxHeight && randomEngine() % branching == 0){
+        nodeHeight++;
+    }
+    return nodeHeight;
+}
+
+#endif
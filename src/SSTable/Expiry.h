@@ -0,0 +1,26 @@
+#ifndef DATAINTENSIVE_EXPIRY_H
+#define DATAINTENSIVE_EXPIRY_H
+
+#include <chrono>
+#include <cstdint>
+
+/*
+ * Expiry times of entries inserted with a TTL. They are milliseconds since the Unix epoch, so they keep their
+ * meaning across restarts.
+ */
+namespace Expiry {
+    inline uint64_t now(){
+        using namespace std::chrono;
+        return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+    }
+
+    inline uint64_t after(std::chrono::milliseconds ttl){
+        return now() + ttl.count();
+    }
+
+    inline bool hasPassed(uint64_t expiresAt){
+        return expiresAt <= now();
+    }
+}
+
+#endif
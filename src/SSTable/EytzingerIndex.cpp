@@ -0,0 +1,46 @@
+#include "EytzingerIndex.h"
+#include <cstring>
+#include "PaddedKeySearch.h"
+
+EytzingerIndex::EytzingerIndex(const char *sortedPairs, size_t numPairs, size_t pairLength, size_t fixedKeySize)
+        : numPairs(numPairs), pairLength(pairLength), fixedKeySize(fixedKeySize), pairs((numPairs + 1) * pairLength) {
+    build(sortedPairs, 0, 1);
+}
+
+const char *EytzingerIndex::find(const char *paddedKey) const {
+    size_t k = 1;
+    while (k <= numPairs){
+        // The four grandchildren of k are contiguous, so by the time we get there they are likely already cached
+        for (size_t grandchild = 4 * k; grandchild < 4 * k + 4 && grandchild <= numPairs; grandchild++){
+            __builtin_prefetch(slot(grandchild));
+        }
+        k = 2 * k + (PaddedKeySearch::compare(slot(k), paddedKey, fixedKeySize) < 0);
+    }
+
+    /*
+     * Every right turn appends a 1 bit to k and every left turn a 0 bit. The lower bound is the last node at
+     * which we turned left, which we get by dropping the trailing right turns and that last left turn.
+     */
+    k >>= __builtin_ffsll(static_cast<long long>(~k));
+    if (k == 0 || PaddedKeySearch::compare(slot(k), paddedKey, fixedKeySize) != 0){
+        return nullptr;
+    }
+
+    return slot(k);
+}
+
+size_t EytzingerIndex::build(const char *sortedPairs, size_t next, size_t k) {
+    // An in-order traversal of the implicit tree visits slots in sorted order
+    if (k <= numPairs){
+        next = build(sortedPairs, next, 2 * k);
+        std::memcpy(pairs.data() + k * pairLength, sortedPairs + next * pairLength, pairLength);
+        next++;
+        next = build(sortedPairs, next, 2 * k + 1);
+    }
+
+    return next;
+}
+
+const char *EytzingerIndex::slot(size_t k) const {
+    return pairs.data() + k * pairLength;
+}
@@ -0,0 +1,33 @@
+#ifndef DATAINTENSIVE_EYTZINGERINDEX_H
+#define DATAINTENSIVE_EYTZINGERINDEX_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Copy of a KeyChunk's key-offset pairs in Eytzinger (BFS) order: the root of the implicit binary search tree
+ * is stored at slot 1, and the children of slot k at slots 2k and 2k+1. A search walks the array front to back,
+ * so the top levels of the tree share a few cache lines, and the slots a search may visit a couple of levels
+ * down are contiguous and can be prefetched while the current comparison is running. A sorted array instead
+ * takes a cache miss at almost every step of a binary search.
+ */
+class EytzingerIndex {
+public:
+    EytzingerIndex(const char *sortedPairs, size_t numPairs, size_t pairLength, size_t fixedKeySize);
+    /*
+     * Returns the key-offset pair whose key equals paddedKey, or nullptr if there is none.
+     */
+    const char* find(const char *paddedKey) const;
+
+private:
+    size_t numPairs;
+    size_t pairLength;
+    size_t fixedKeySize;
+    std::vector<char> pairs;
+
+    size_t build(const char *sortedPairs, size_t next, size_t k);
+    const char* slot(size_t k) const;
+};
+
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef DATAINTENSIVE_HASHINDEX_HPP
+#define DATAINTENSIVE_HASHINDEX_HPP
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+/*
+ * Open addressing hash table from a key to the node that holds it, kept next to an ordered memcache so point
+ * lookups take one probe sequence instead of O(log n) key comparisons. Slots only hold the node and the key's
+ * hash: keys are read from node->key, so the table holds no copy of them, and the stored hash lets probes skip
+ * most key comparisons.
+ *
+ * Collisions use linear probing, and erase shifts the rest of the probe sequence back instead of leaving
+ * tombstones, so lookups never slow down after many removals.
+ */
+template<class K, class Node>
+class HashIndex {
+public:
+
+    Node* find(const K& key) const;
+    /*
+     * Adds the key, or points it to node if it is already there
+     */
+    void insert(const K& key, Node *node);
+    void erase(const K& key);
+    void clear();
+    size_t memoryUsage() const;
+
+private:
+
+    struct Slot {
+        size_t hash;
+        Node *node;
+    };
+
+    static constexpr size_t minCapacity = 16;
+
+    /*
+     * Capacity is a power of two, and the table grows once it is 3/4 full
+     */
+    std::vector<Slot> slots;
+    size_t used = 0;
+
+    size_t findSlot(const K& key, size_t hash) const;
+    void grow();
+    size_t mask() const;
+};
+
+template<class K, class Node>
+Node* HashIndex<K, Node>::find(const K &key) const {
+    if (slots.empty()){
+        return nullptr;
+    }
+
+    return slots[findSlot(key, std::hash<K>{}(key))].node;
+}
+
+template<class K, class Node>
+void HashIndex<K, Node>::insert(const K &key, Node *node) {
+    if ((used + 1) * 4 > slots.size() * 3){
+        grow();
+    }
+
+    auto hash = std::hash<K>{}(key);
+    auto &slot = slots[findSlot(key, hash)];
+    if (!slot.node){
+        used++;
+    }
+    slot = {hash, node};
+}
+
+template<class K, class Node>
+void HashIndex<K, Node>::erase(const K &key) {
+    if (slots.empty()){
+        return;
+    }
+
+    auto hole = findSlot(key, std::hash<K>{}(key));
+    if (!slots[hole].node){
+        return;
+    }
+
+    // Move back every entry whose probe sequence passes through the hole, so lookups still reach them
+    for (auto next = (hole + 1) & mask(); slots[next].node; next = (next + 1) & mask()){
+        auto home = slots[next].hash & mask();
+        if (((next - home) & mask()) >= ((next - hole) & mask())){
+            slots[hole] = slots[next];
+            hole = next;
+        }
+    }
+
+    slots[hole] = {0, nullptr};
+    used--;
+}
+
+template<class K, class Node>
+void HashIndex<K, Node>::clear() {
+    std::vector<Slot>().swap(slots);
+    used = 0;
+}
+
+template<class K, class Node>
+size_t HashIndex<K, Node>::memoryUsage() const {
+    return slots.capacity() * sizeof(Slot);
+}
+
+template<class K, class Node>
+size_t HashIndex<K, Node>::findSlot(const K &key, size_t hash) const {
+    auto pos = hash & mask();
+    while (slots[pos].node && (slots[pos].hash != hash || !(slots[pos].node->key == key))){
+        pos = (pos + 1) & mask();
+    }
+
+    return pos;
+}
+
+template<class K, class Node>
+void HashIndex<K, Node>::grow() {
+    std::vector<Slot> old(std::max(minCapacity, 2 * slots.size()), Slot{0, nullptr});
+    old.swap(slots);
+    for (const auto &slot : old){
+        if (slot.node){
+            auto pos = slot.hash & mask();
+            while (slots[pos].node){
+                pos = (pos + 1) & mask();
+            }
+            slots[pos] = slot;
+        }
+    }
+}
+
+template<class K, class Node>
+size_t HashIndex<K, Node>::mask() const {
+    return slots.size() - 1;
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef DATAINTENSIVE_KEYFILTER_H
+#define DATAINTENSIVE_KEYFILTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Stored in the SSFile header, so the numeric values must not change.
+ */
+enum class FilterType : uint32_t {
+    NONE = 0,
+    BLOOM = 1,
+    XOR = 2
+};
+
+/*
+ * Approximate membership filter stored alongside an SSFile. A filter may return false positives, but never
+ * false negatives.
+ */
+class KeyFilter {
+public:
+    virtual bool canContainKey(const std::string &key) const = 0;
+    /*
+     * Encoded form of the filter, as written to the SSFile. Its length is stored in the SSFile header.
+     */
+    virtual std::vector<uint8_t> serialize() const = 0;
+    virtual ~KeyFilter() = default;
+};
+
+#endif
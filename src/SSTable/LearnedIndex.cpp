@@ -0,0 +1,118 @@
+#include "LearnedIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+LearnedIndex::LearnedIndex(const std::vector<std::string_view> &sortedKeys, uint32_t targetError) : commonPrefixLength(0), numKeys(sortedKeys.size()) {
+    if (sortedKeys.empty()){
+        return;
+    }
+
+    // Keys are sorted, so the prefix shared by the first and the last key is shared by all of them
+    auto first = sortedKeys.front();
+    auto last = sortedKeys.back();
+    while (commonPrefixLength < first.size() && commonPrefixLength < last.size() && first[commonPrefixLength] == last[commonPrefixLength]){
+        commonPrefixLength++;
+    }
+
+    std::vector<uint64_t> xs;
+    xs.reserve(sortedKeys.size());
+    for (const auto &key : sortedKeys){
+        xs.push_back(keyToNumber(key));
+    }
+
+    /*
+     * Greedy "shrinking cone" fit: a segment starts at its first key, and keeps the range of slopes for which every
+     * key seen so far is within targetError of its prediction. Once that range is empty, a new segment starts.
+     */
+    size_t start = 0;
+    while (start < xs.size()){
+        double minSlope = 0;
+        double maxSlope = std::numeric_limits<double>::infinity();
+        size_t end = start + 1;
+        while (end < xs.size()){
+            double y = static_cast<double>(end - start);
+            if (xs[end] == xs[start]){
+                // Keys that map to the same number all get the same prediction, so no slope can fix their error
+                end++;
+                continue;
+            }
+
+            double dx = static_cast<double>(xs[end] - xs[start]);
+            double newMin = std::max(minSlope, (y - targetError) / dx);
+            double newMax = std::min(maxSlope, (y + targetError) / dx);
+            if (newMin > newMax){
+                break;
+            }
+            minSlope = newMin;
+            maxSlope = newMax;
+            end++;
+        }
+
+        // A run of keys that map to the same number must not be split, or predict could pick the wrong segment
+        while (end < xs.size() && xs[end] == xs[end - 1]){
+            end++;
+        }
+
+        Segment segment{xs[start], std::isinf(maxSlope) ? 0 : (minSlope + maxSlope) / 2, static_cast<uint32_t>(start), 0};
+        // Measure the error with the same arithmetic used by predict, so rounding can never break the bound
+        for (size_t i = start; i < end; i++){
+            auto predicted = static_cast<long long>(std::llround(predictPosition(segment, xs[i])));
+            auto error = static_cast<uint32_t>(std::llabs(predicted - static_cast<long long>(i)));
+            segment.maxError = std::max(segment.maxError, error);
+        }
+
+        segments.push_back(segment);
+        start = end;
+    }
+}
+
+LearnedIndex::LearnedIndex(const std::vector<std::string> &sortedKeys, uint32_t targetError)
+        : LearnedIndex(std::vector<std::string_view>(sortedKeys.begin(), sortedKeys.end()), targetError) {}
+
+LearnedIndex::LearnedIndex(uint32_t commonPrefixLength, std::vector<Segment> segments, size_t numKeys)
+        : commonPrefixLength(commonPrefixLength), segments(std::move(segments)), numKeys(numKeys) {}
+
+LearnedIndex::SearchWindow LearnedIndex::predict(const std::string &key) const {
+    auto x = keyToNumber(key);
+    // The segment responsible for x is the last one starting at or before it
+    auto it = std::upper_bound(segments.begin(), segments.end(), x, [](uint64_t x, const Segment &segment){
+        return x < segment.firstKey;
+    });
+    if (it == segments.begin()){
+        return {0, 0};
+    }
+
+    const auto &segment = *(it - 1);
+    auto predicted = std::llround(predictPosition(segment, x));
+    auto lo = std::max<long long>(0, predicted - segment.maxError);
+    auto hi = std::min<long long>(static_cast<long long>(numKeys), predicted + segment.maxError + 1);
+    if (lo >= hi){
+        return {0, 0};
+    }
+
+    return {static_cast<size_t>(lo), static_cast<size_t>(hi)};
+}
+
+uint32_t LearnedIndex::getCommonPrefixLength() const {
+    return commonPrefixLength;
+}
+
+const std::vector<LearnedIndex::Segment> &LearnedIndex::getSegments() const {
+    return segments;
+}
+
+uint64_t LearnedIndex::keyToNumber(std::string_view key) const {
+    // Big endian, so that numbers compare like the keys do. Missing bytes act as the '\0' padding in the chunk.
+    uint64_t x = 0;
+    for (size_t i = 0; i < sizeof(x); i++){
+        size_t pos = commonPrefixLength + i;
+        x = (x << 8) | (pos < key.size() ? static_cast<unsigned char>(key[pos]) : 0);
+    }
+
+    return x;
+}
+
+double LearnedIndex::predictPosition(const Segment &segment, uint64_t x) {
+    return segment.firstPosition + segment.slope * static_cast<double>(x - segment.firstKey);
+}
@@ -0,0 +1,55 @@
+#ifndef DATAINTENSIVE_LEARNEDINDEX_H
+#define DATAINTENSIVE_LEARNEDINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Piecewise linear model of the position of each key within a sorted KeyChunk. Keys are mapped to a number by
+ * taking the 8 bytes that follow the prefix shared by every key in the chunk, and each segment predicts the
+ * position of the keys from its first key on. Every key in the chunk is guaranteed to be within the segment's
+ * maxError of the predicted position, so a lookup only needs to binary search that window.
+ *
+ * The model works best for keys that are close to evenly spaced once the common prefix is removed, such as
+ * monotonically increasing ids.
+ */
+class LearnedIndex {
+public:
+    struct Segment {
+        uint64_t firstKey;
+        double slope;
+        uint32_t firstPosition;
+        uint32_t maxError;
+    };
+
+    /*
+     * Positions [lo, hi) that may hold the key
+     */
+    struct SearchWindow {
+        size_t lo;
+        size_t hi;
+    };
+
+    /*
+     * Fits segments so that no key is more than targetError positions away from its prediction. Keys must be sorted.
+     */
+    LearnedIndex(const std::vector<std::string_view> &sortedKeys, uint32_t targetError);
+    LearnedIndex(const std::vector<std::string> &sortedKeys, uint32_t targetError);
+    LearnedIndex(uint32_t commonPrefixLength, std::vector<Segment> segments, size_t numKeys);
+    SearchWindow predict(const std::string &key) const;
+    uint32_t getCommonPrefixLength() const;
+    const std::vector<Segment>& getSegments() const;
+
+private:
+    uint32_t commonPrefixLength;
+    std::vector<Segment> segments;
+    size_t numKeys;
+
+    uint64_t keyToNumber(std::string_view key) const;
+    static double predictPosition(const Segment &segment, uint64_t x);
+};
+
+
+#endif
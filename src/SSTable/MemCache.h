@@ -8,18 +8,116 @@
 #include <memory>
 #include <stack>
 #include <functional>
+#include <iterator>
+#include <variant>
 
+/*
+ * Heap memory owned by a key or value, on top of its sizeof. Memcaches add this to the size of their nodes to
+ * keep track of memoryUsage() as entries come and go.
+ */
+template<class T>
+size_t approximateHeapSize(const T &){
+    return 0;
+}
+
+inline size_t approximateHeapSize(const std::string &str){
+    return str.size();
+}
+
+template<class... Ts>
+size_t approximateHeapSize(const std::variant<Ts...> &variant){
+    return std::visit([](const auto &alternative){ return approximateHeapSize(alternative); }, variant);
+}
 
 template<class K, class V>
 class MemCache {
 public:
+
+    /*
+     * Position in a sorted walk over the memcache, provided by each implementation. Only valid until the
+     * memcache is modified.
+     */
+    class Cursor {
+    public:
+        virtual bool valid() const = 0;
+        virtual void next() = 0;
+        virtual const K& key() const = 0;
+        virtual const V& value() const = 0;
+        virtual ~Cursor() = default;
+    };
+
+    struct Entry {
+        const K &key;
+        const V &value;
+    };
+
+    /*
+     * Single pass iterator over the entries in key order, so callers can stream a memcache with a range based
+     * for loop instead of a callback. Like the Cursor it wraps, it is invalidated by any modification.
+     */
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Entry;
+
+        Iterator() = default;
+        explicit Iterator(std::unique_ptr<Cursor> cursor) : cursor(std::move(cursor)) {
+            if (this->cursor && !this->cursor->valid()){
+                this->cursor.reset();
+            }
+        };
+
+        Entry operator*() const {
+            return {cursor->key(), cursor->value()};
+        }
+
+        Iterator& operator++() {
+            cursor->next();
+            if (!cursor->valid()){
+                cursor.reset();
+            }
+            return *this;
+        }
+
+        /*
+         * Only comparisons against end() are meaningful
+         */
+        bool operator==(const Iterator &other) const {
+            return cursor == other.cursor;
+        }
+
+        bool operator!=(const Iterator &other) const {
+            return !(*this == other);
+        }
+
+    private:
+        std::unique_ptr<Cursor> cursor;
+    };
+
     virtual void insert(const K &key, const V &value) = 0;
     virtual std::optional<V> get(const K &k) const = 0;
     virtual bool remove(const K& key) = 0;
     virtual void traverseSorted(const std::function<void(const K& k, const V& v)>& callback) const = 0;
+    virtual std::unique_ptr<Cursor> newCursor() const = 0;
     virtual size_t size() const = 0;
+    /*
+     * Approximate number of bytes held by the memcache, including memory owned by its keys and values. Lets
+     * memcaches be flushed at a byte budget rather than at a number of entries, whatever the size of the values.
+     */
+    virtual size_t memoryUsage() const = 0;
     virtual void clear() = 0;
     virtual ~MemCache() = default;
+
+    Iterator begin() const {
+        return Iterator(newCursor());
+    }
+
+    Iterator end() const {
+        return Iterator();
+    }
 };
 
 #endif
@@ -0,0 +1,72 @@
+#include "MergeOperator.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+    bool isNumber(const DbValue &value){
+        return value.index() == intType || value.index() == longType || value.index() == doubleType;
+    }
+
+    double asDouble(const DbValue &value){
+        return std::visit([](const auto &number) -> double {
+            if constexpr (std::is_arithmetic_v<std::decay_t<decltype(number)>>){
+                return static_cast<double>(number);
+            } else {
+                return 0;
+            }
+        }, value);
+    }
+
+    long asLong(const DbValue &value){
+        return value.index() == intType ? std::get<int>(value) : std::get<long>(value);
+    }
+
+    std::runtime_error typeMismatch(const std::string &operatorName, const DbValue &older, const DbValue &newer){
+        return std::runtime_error(operatorName + " merge operator can't combine values of types " +
+                                  std::to_string(older.index()) + " and " + std::to_string(newer.index()));
+    }
+}
+
+DbValue AddOperator::merge(const DbValue &older, const DbValue &newer) const {
+    if (!isNumber(older) || !isNumber(newer)){
+        throw typeMismatch("Add", older, newer);
+    }
+
+    auto widest = std::max(older.index(), newer.index());
+    if (widest == intType || widest == longType){
+        long sum;
+        if (__builtin_add_overflow(asLong(older), asLong(newer), &sum)){
+            throw std::runtime_error("Add merge operator overflowed adding " + std::to_string(asLong(newer)) +
+                                     " to " + std::to_string(asLong(older)));
+        }
+        // A sum of ints that doesn't fit in an int is kept as a long
+        if (widest == intType && sum >= std::numeric_limits<int>::min() && sum <= std::numeric_limits<int>::max()){
+            return static_cast<int>(sum);
+        }
+        return sum;
+    }
+    return asDouble(older) + asDouble(newer);
+}
+
+DbValue MaxOperator::merge(const DbValue &older, const DbValue &newer) const {
+    if (isNumber(older) && isNumber(newer)){
+        return asDouble(newer) > asDouble(older) ? newer : older;
+    }
+    if (older.index() != newer.index()){
+        throw typeMismatch("Max", older, newer);
+    }
+
+    return newer > older ? newer : older;
+}
+
+StringAppendOperator::StringAppendOperator(std::string delimiter) : delimiter(std::move(delimiter)) {}
+
+DbValue StringAppendOperator::merge(const DbValue &older, const DbValue &newer) const {
+    if (older.index() != stringType || newer.index() != stringType){
+        throw typeMismatch("String append", older, newer);
+    }
+
+    return std::get<std::string>(older) + delimiter + std::get<std::string>(newer);
+}
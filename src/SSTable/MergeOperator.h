@@ -0,0 +1,54 @@
+#ifndef DATAINTENSIVE_MERGEOPERATOR_H
+#define DATAINTENSIVE_MERGEOPERATOR_H
+
+#include <string>
+#include "../DatabaseEntry.h"
+
+/*
+ * Combines the operands passed to SSTableDb::merge with the value of the key. Operands are stored as merge records
+ * and only folded when the key is read, flushed or compacted, and in between consecutive operands are folded with
+ * each other, so merge must be associative: merge(merge(a, b), c) == merge(a, merge(b, c)). A key without a value
+ * takes the first operand as its value.
+ *
+ * merge throws for values it can't combine. SSTableDb::merge then fails if the key's value is in the memcache, and
+ * otherwise reads (and compactions) of the key fail once the operand is stored.
+ */
+class MergeOperator {
+public:
+    /*
+     * older is the value or operand written first
+     */
+    virtual DbValue merge(const DbValue &older, const DbValue &newer) const = 0;
+    virtual ~MergeOperator() = default;
+};
+
+/*
+ * Sums numbers, so counters can be incremented without reading them. Mixed types widen to the wider of the two
+ * (int to long to double), and ints whose sum overflows an int become a long. Overflowing a long throws.
+ */
+class AddOperator : public MergeOperator {
+public:
+    DbValue merge(const DbValue &older, const DbValue &newer) const override;
+};
+
+/*
+ * Keeps the larger value. Numbers of different types are compared as doubles, and keep the type of the larger.
+ */
+class MaxOperator : public MergeOperator {
+public:
+    DbValue merge(const DbValue &older, const DbValue &newer) const override;
+};
+
+/*
+ * Appends string operands to the string value, separated by delimiter
+ */
+class StringAppendOperator : public MergeOperator {
+public:
+    explicit StringAppendOperator(std::string delimiter = "");
+    DbValue merge(const DbValue &older, const DbValue &newer) const override;
+
+private:
+    std::string delimiter;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include "PaddedKeySearch.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PADDED_KEY_SEARCH_AVX2
+#endif
+
+namespace {
+    int firstDifference(const char *lhs, const char *rhs, size_t i){
+        return static_cast<unsigned char>(lhs[i]) - static_cast<unsigned char>(rhs[i]);
+    }
+
+    /*
+     * Compares the bytes from i on
+     */
+    int compareFrom(const char *lhs, const char *rhs, size_t fixedKeySize, size_t i){
+#ifdef __SSE2__
+        for (; i + 16 <= fixedKeySize; i += 16){
+            auto l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i));
+            auto r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + i));
+            auto differing = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(l, r))) & 0xFFFF;
+            if (differing){
+                return firstDifference(lhs, rhs, i + __builtin_ctz(differing));
+            }
+        }
+#endif
+        // Every chunk key size is a multiple of 8, so this handles 8 byte keys and whatever is left of longer ones.
+        for (; i + 8 <= fixedKeySize; i += 8){
+            uint64_t l, r;
+            std::memcpy(&l, lhs + i, sizeof(l));
+            std::memcpy(&r, rhs + i, sizeof(r));
+            if (l != r){
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+                // Byte swap so the first byte in memory is the most significant one
+                l = __builtin_bswap64(l);
+                r = __builtin_bswap64(r);
+#endif
+                return l < r ? -1 : 1;
+            }
+        }
+
+        return std::memcmp(lhs + i, rhs + i, fixedKeySize - i);
+    }
+
+#ifdef PADDED_KEY_SEARCH_AVX2
+    /*
+     * Compiled for AVX2 whatever the build flags, and only called when the CPU running it supports AVX2
+     */
+    __attribute__((target("avx2")))
+    int compareAvx2(const char *lhs, const char *rhs, size_t fixedKeySize){
+        size_t i = 0;
+        for (; i + 32 <= fixedKeySize; i += 32){
+            auto l = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i));
+            auto r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i));
+            auto differing = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(l, r)));
+            if (differing){
+                return firstDifference(lhs, rhs, i + __builtin_ctz(differing));
+            }
+        }
+
+        return compareFrom(lhs, rhs, fixedKeySize, i);
+    }
+
+    const bool cpuHasAvx2 = [](){
+        // Static initializers may run before the compiler's own CPU detection
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+#endif
+}
+
+std::string PaddedKeySearch::pad(const std::string &key, size_t fixedKeySize) {
+    std::string padded = key;
+    padded.resize(fixedKeySize, '\0');
+    return padded;
+}
+
+int PaddedKeySearch::compare(const char *lhs, const char *rhs, size_t fixedKeySize) {
+#ifdef PADDED_KEY_SEARCH_AVX2
+    // Keys shorter than one AVX2 vector gain nothing from it
+    if (cpuHasAvx2 && fixedKeySize >= 32){
+        return compareAvx2(lhs, rhs, fixedKeySize);
+    }
+#endif
+    return compareFrom(lhs, rhs, fixedKeySize, 0);
+}
+
+size_t PaddedKeySearch::lowerBound(const char *pairs, size_t numPairs, size_t pairLength, const char *paddedKey,
+                                   size_t fixedKeySize) {
+    if (numPairs == 0){
+        return 0;
+    }
+
+    /*
+     * Branchless binary search: the remaining range always shrinks by half, and the only data dependent choice
+     * is where it starts, which compiles to a conditional move instead of a branch that is mispredicted half the time.
+     */
+    const char *base = pairs;
+    size_t remaining = numPairs;
+    while (remaining > 1){
+        size_t half = remaining / 2;
+        const char *middle = base + half * pairLength;
+        base = compare(middle, paddedKey, fixedKeySize) < 0 ? middle : base;
+        remaining -= half;
+    }
+
+    size_t index = (base - pairs) / pairLength;
+    return index + (compare(base, paddedKey, fixedKeySize) < 0);
+}
@@ -0,0 +1,31 @@
+#ifndef DATAINTENSIVE_PADDEDKEYSEARCH_H
+#define DATAINTENSIVE_PADDEDKEYSEARCH_H
+
+#include <cstddef>
+#include <string>
+
+/*
+ * Search over the fixed-width, NUL-padded keys of a KeyChunk that is held in memory. Since keys never contain
+ * '\0', comparing two padded keys byte by byte (as unsigned chars) gives the same order as comparing the
+ * unpadded std::strings, so no string needs to be built while searching.
+ */
+namespace PaddedKeySearch {
+
+    std::string pad(const std::string &key, size_t fixedKeySize);
+
+    /*
+     * Returns a negative number, zero or a positive number if lhs is smaller, equal or larger than rhs. Compares
+     * 32 bytes at a time with AVX2 when the CPU supports it, whatever the build flags, and 16 at a time with SSE2
+     * otherwise.
+     */
+    int compare(const char *lhs, const char *rhs, size_t fixedKeySize);
+
+    /*
+     * Index of the first of numPairs key-offset pairs (each pairLength bytes long, key first) whose key is not
+     * smaller than paddedKey, or numPairs if there is none.
+     */
+    size_t lowerBound(const char *pairs, size_t numPairs, size_t pairLength, const char *paddedKey, size_t fixedKeySize);
+};
+
+
+#endif
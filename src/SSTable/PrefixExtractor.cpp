@@ -0,0 +1,44 @@
+#include "PrefixExtractor.h"
+#include <stdexcept>
+
+PrefixExtractor::PrefixExtractor() : PrefixExtractor(Type::NONE, 0) {}
+
+PrefixExtractor::PrefixExtractor(PrefixExtractor::Type type, uint32_t parameter) : type(type), parameter(parameter) {}
+
+PrefixExtractor PrefixExtractor::fixedLength(uint32_t length) {
+    if (length == 0){
+        throw std::runtime_error("Prefix length must be positive");
+    }
+
+    return {Type::FIXED_LENGTH, length};
+}
+
+PrefixExtractor PrefixExtractor::upToDelimiter(char delimiter) {
+    return {Type::DELIMITER, static_cast<unsigned char>(delimiter)};
+}
+
+bool PrefixExtractor::isEnabled() const {
+    return type != Type::NONE;
+}
+
+std::optional<std::string> PrefixExtractor::extract(const std::string &key) const {
+    switch (type) {
+        case Type::NONE:
+            return std::nullopt;
+        case Type::FIXED_LENGTH: {
+            if (key.size() < parameter){
+                return std::nullopt;
+            }
+            return key.substr(0, parameter);
+        }
+        case Type::DELIMITER: {
+            auto pos = key.find(static_cast<char>(parameter));
+            if (pos == std::string::npos){
+                return std::nullopt;
+            }
+            return key.substr(0, pos + 1);
+        }
+    }
+
+    throw std::runtime_error("Unrecognized prefix extractor type " + std::to_string(static_cast<uint32_t>(type)));
+}
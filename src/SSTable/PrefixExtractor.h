@@ -0,0 +1,45 @@
+#ifndef DATAINTENSIVE_PREFIXEXTRACTOR_H
+#define DATAINTENSIVE_PREFIXEXTRACTOR_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/*
+ * Maps a key to the prefix stored in an SSFile's prefix filter. The extractor is written to the SSFile header as
+ * is, so it must stay trivially copyable.
+ *
+ * For a scan prefix, extract() returns the prefix shared by every key that starts with it, or nullopt if there is
+ * no such prefix (e.g. the scan prefix is shorter than the fixed length, or does not contain the delimiter). In the
+ * latter case the prefix filter cannot be used for that scan.
+ */
+class PrefixExtractor {
+public:
+    enum class Type : uint32_t {
+        NONE = 0,
+        FIXED_LENGTH = 1,
+        DELIMITER = 2
+    };
+
+    PrefixExtractor();
+    static PrefixExtractor fixedLength(uint32_t length);
+    /*
+     * The prefix runs up to and including the first occurrence of delimiter, e.g. "tenant:" for "tenant:entity:id"
+     */
+    static PrefixExtractor upToDelimiter(char delimiter);
+
+    bool isEnabled() const;
+    std::optional<std::string> extract(const std::string &key) const;
+
+private:
+    PrefixExtractor(Type type, uint32_t parameter);
+
+    Type type;
+    /*
+     * Length for FIXED_LENGTH, delimiter character for DELIMITER
+     */
+    uint32_t parameter;
+};
+
+
+#endif
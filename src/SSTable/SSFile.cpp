@@ -1,87 +1,381 @@
 #include "SSFile.h"
+#include "Expiry.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string_view>
 #include <utility>
 #include <iostream>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+#include "XorFilter.h"
+#include "PaddedKeySearch.h"
+#include "SSFileCursor.h"
 
-SSFile::SSFile(std::fstream file) : file(std::move(file)) {
-    header = readSSFileHeader();
-    if (header.hasBloomFilter()){
-        bloomFilter = readBloomFilter(header.bloomFilterLength());
+SSFile::SSFile(const std::filesystem::path &path, const SSFileOptions &options) {
+    file.exceptions(std::ios::badbit | std::ios::failbit);
+    file.open(path, std::ios::in | std::ios::binary);
+    reader = AsyncReader::open(path, options.readBackend);
+    header = readSSFileHeader(path);
+    this->file.seekg(header.filterStart);
+    if (header.hasFilter()){
+        filter = readFilter(header.filterType, header.filterLength);
     }
+    if (header.hasPrefixFilter()){
+        prefixFilter = readFilter(header.prefixFilterType, header.prefixFilterLength);
+    }
+    keyChunks = readKeyChunkHeaders();
+    if (header.hasLearnedIndex()){
+        readLearnedIndexes();
+    }
+    if (options.keyIndexInMemory || options.eytzingerKeyIndex){
+        loadKeyIndex(options.eytzingerKeyIndex);
+    }
+
+    // Opened last, so nothing can throw and leak it before the destructor is guaranteed to run
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0){
+        throw std::system_error(errno, std::generic_category(), "Couldn't open " + path.string());
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+SSFile::~SSFile() {
+    close(fd);
 }
 
 SSFileRead SSFile::get(const std::string &key) {
-    if (bloomFilter.has_value()){
-        if (!bloomFilter.value().canContainKey(key)){
-            return {KEY_NOT_FOUND};
-        }
+    if (filter && !filter->canContainKey(key)){
+        return {KEY_NOT_FOUND};
     }
 
-    auto chunkHeader = moveToChunkForKey(key);
-    offset chunkStart = file.tellg();
-    auto valueOffset = findValueOffset(chunkStart, chunkHeader, key);
+    auto chunk = findChunkForKey(key);
+    auto valueOffset = keyIndex.empty() ? findValueOffset(chunk, key) : findValueOffsetInMemory(chunk, key);
+
     if (!valueOffset.has_value()){
         return {KEY_NOT_FOUND};
     }
 
-    file.seekg(valueOffset.value());
-    auto valueHeader = readValueHeader();
-    if (valueHeader.isEntryRemoved()){
-        return {KEY_TOMBSTONE};
+    return readEntry(valueOffset.value());
+}
+
+std::vector<SSFileRead> SSFile::multiGet(const std::vector<std::string> &sortedKeys) {
+    std::vector<SSFileRead> reads(sortedKeys.size(), SSFileRead{KEY_NOT_FOUND});
+    auto chunks = readKeyChunkHeaders();
+    std::vector<std::vector<size_t>> keysByChunk(chunks.size());
+    for (size_t i = 0; i < sortedKeys.size(); i++){
+        if (filter && !filter->canContainKey(sortedKeys[i])){
+            continue;
+        }
+
+        size_t chunk = 0;
+        while (sortedKeys[i].size() > chunks[chunk].second.fixedKeySize){
+            chunk++;
+        }
+        keysByChunk[chunk].push_back(i);
+    }
+
+    std::vector<std::pair<offset, size_t>> valueOffsets;
+    if (reader && keyIndex.empty()){
+        std::vector<size_t> candidates;
+        for (const auto &chunkKeys : keysByChunk){
+            candidates.insert(candidates.end(), chunkKeys.begin(), chunkKeys.end());
+        }
+        valueOffsets = findValueOffsetsBatched(sortedKeys, candidates);
+    } else {
+        // Keys within a chunk are sorted, so each search can start where the previous one ended
+        for (size_t chunk = 0; chunk < chunks.size(); chunk++){
+            const auto &[chunkStart, chunkHeader] = chunks[chunk];
+            size_t lo = 0;
+            for (auto keyIndex : keysByChunk[chunk]){
+                lo = lowerBoundInChunk(chunkStart, chunkHeader, sortedKeys[keyIndex], lo);
+                if (lo == chunkHeader.getNumKeysInChunk()){
+                    break;
+                }
+
+                auto keyOffsetPair = keyOffsetPairAt(chunkStart, chunkHeader, lo);
+                if (keyOffsetPair.key == sortedKeys[keyIndex]){
+                    valueOffsets.emplace_back(keyOffsetPair.pos, keyIndex);
+                }
+            }
+        }
+    }
+
+    std::sort(valueOffsets.begin(), valueOffsets.end());
+    std::vector<offset> offsets;
+    offsets.reserve(valueOffsets.size());
+    for (const auto &[valueOffset, keyIndex] : valueOffsets){
+        offsets.push_back(valueOffset);
+    }
+
+    auto entries = readEntries(offsets);
+    for (size_t i = 0; i < valueOffsets.size(); i++){
+        reads[valueOffsets[i].second] = std::move(entries[i]);
+    }
+
+    return reads;
+}
+
+std::vector<std::pair<std::string, SSFileRead>> SSFile::scanPrefix(const std::string &prefix) {
+    if (!canContainPrefix(prefix)){
+        return {};
+    }
+
+    std::vector<KeyOffsetPair> matches;
+    for (const auto &[chunkStart, chunkHeader] : readKeyChunkHeaders()){
+        // Keys in a chunk are at most fixedKeySize long, so shorter chunks cannot hold keys starting with prefix
+        if (chunkHeader.fixedKeySize >= prefix.size()){
+            findPrefixMatches(chunkStart, chunkHeader, prefix, matches);
+        }
+    }
+
+    // Values are laid out in key order, but keys are split across chunks. Reading in offset order keeps reads sequential.
+    std::sort(matches.begin(), matches.end(), [](const KeyOffsetPair &lhs, const KeyOffsetPair &rhs){
+        return lhs.pos < rhs.pos;
+    });
+
+    std::vector<offset> offsets;
+    offsets.reserve(matches.size());
+    for (const auto &match : matches){
+        offsets.push_back(match.pos);
+    }
+
+    auto reads = readEntries(offsets);
+    std::vector<std::pair<std::string, SSFileRead>> entries;
+    entries.reserve(matches.size());
+    for (size_t i = 0; i < matches.size(); i++){
+        entries.emplace_back(std::move(matches[i].key), std::move(reads[i]));
     }
 
-    auto value =  readValue(valueHeader);
-    return {KEY_FOUND, value};
+    std::sort(entries.begin(), entries.end(), [](const auto &lhs, const auto &rhs){
+        return lhs.first < rhs.first;
+    });
+    return entries;
+}
+
+bool SSFile::canContainPrefix(const std::string &prefix) const {
+    if (!prefixFilter){
+        return true;
+    }
+
+    auto extracted = header.prefixExtractor.extract(prefix);
+    if (!extracted.has_value()){
+        return true;
+    }
+
+    return prefixFilter->canContainKey(extracted.value());
+}
+
+std::unique_ptr<SSFileCursor> SSFile::newCursor(bool adaptiveReadahead) const {
+    return std::make_unique<SSFileCursor>(*this, adaptiveReadahead);
 }
 
 size_t SSFile::getIndex() const {
     return header.index;
 }
 
-std::optional<SSFile::offset> SSFile::findValueOffset(SSFile::offset chunkStart, SSFile::KeyChunkHeader chunkHeader, const std::string &key) {
-    int lo = 0;
-    int hi = static_cast<int>(chunkHeader.getNumKeysInChunk() - 1);
-    int mid = lo + ((hi - lo) / 2);
-    while (lo <= hi){
-        file.seekg(chunkStart + mid * chunkHeader.keyOffsetPairLength());
+std::optional<SSFile::offset> SSFile::findValueOffset(size_t chunk, const std::string &key) {
+    const auto &[chunkStart, chunkHeader] = keyChunks[chunk];
+    auto window = searchWindow(chunk, key);
+    size_t lo = window.lo;
+    size_t hi = window.hi;
+    while (lo < hi){
+        size_t mid = lo + ((hi - lo) / 2);
+        file.seekg(chunkStart + static_cast<offset>(mid * chunkHeader.keyOffsetPairLength()));
         auto keyOffsetPair = readKeyOffsetPair(chunkHeader.fixedKeySize);
         if (key == keyOffsetPair.key){
             return keyOffsetPair.pos;
         } else if (key < keyOffsetPair.key){
-            hi = mid - 1;
+            hi = mid;
         } else {
             lo = mid + 1;
         }
-        mid = lo + ((hi - lo) / 2);
     }
 
     return std::nullopt;
 }
 
-SSFile::KeyChunkHeader SSFile::moveToChunkForKey(const std::string &key) {
+void SSFile::loadKeyIndex(bool buildEytzingerIndexes) {
+    file.seekg(0, std::ios::end);
+    offset fileEnd = file.tellg();
+    keyIndex.resize(fileEnd - header.keyFooterStart);
+    file.seekg(header.keyFooterStart);
+    file.read(keyIndex.data(), static_cast<std::streamsize>(keyIndex.size()));
+
+    if (buildEytzingerIndexes){
+        for (const auto &[chunkStart, chunkHeader] : keyChunks){
+            eytzingerIndexes.emplace_back(keyIndexAt(chunkStart), chunkHeader.getNumKeysInChunk(),
+                                          chunkHeader.keyOffsetPairLength(), chunkHeader.fixedKeySize);
+        }
+    }
+}
+
+std::optional<SSFile::offset> SSFile::findValueOffsetInMemory(size_t chunk, const std::string &key) const {
+    const auto &[chunkStart, chunkHeader] = keyChunks[chunk];
+    auto padded = PaddedKeySearch::pad(key, chunkHeader.fixedKeySize);
+    if (!eytzingerIndexes.empty()){
+        auto pair = eytzingerIndexes[chunk].find(padded.data());
+        if (!pair){
+            return std::nullopt;
+        }
+
+        offset pos;
+        std::memcpy(&pos, pair + chunkHeader.fixedKeySize, sizeof(offset));
+        return pos;
+    }
+
+    auto pairLength = chunkHeader.keyOffsetPairLength();
+    auto window = searchWindow(chunk, key);
+    auto pairs = keyIndexAt(chunkStart);
+    auto index = window.lo + PaddedKeySearch::lowerBound(pairs + window.lo * pairLength, window.hi - window.lo, pairLength,
+                                                         padded.data(), chunkHeader.fixedKeySize);
+    if (index == window.hi || PaddedKeySearch::compare(pairs + index * pairLength, padded.data(), chunkHeader.fixedKeySize) != 0){
+        return std::nullopt;
+    }
+
+    offset pos;
+    std::memcpy(&pos, pairs + index * pairLength + chunkHeader.fixedKeySize, sizeof(offset));
+    return pos;
+}
+
+const char *SSFile::keyIndexAt(SSFile::offset pos) const {
+    return keyIndex.data() + (pos - header.keyFooterStart);
+}
+
+SSFile::KeyOffsetPair SSFile::keyOffsetPairAt(SSFile::offset chunkStart, SSFile::KeyChunkHeader chunkHeader, size_t index) {
+    offset pos = chunkStart + static_cast<offset>(index * chunkHeader.keyOffsetPairLength());
+    if (keyIndex.empty()){
+        file.seekg(pos);
+        return readKeyOffsetPair(chunkHeader.fixedKeySize);
+    }
+
+    auto pair = keyIndexAt(pos);
+    std::string key(pair, strnlen(pair, chunkHeader.fixedKeySize));
+    offset valueOffset;
+    std::memcpy(&valueOffset, pair + chunkHeader.fixedKeySize, sizeof(offset));
+    return {key, valueOffset};
+}
+
+void SSFile::findPrefixMatches(SSFile::offset chunkStart, SSFile::KeyChunkHeader chunkHeader, const std::string &prefix,
+                               std::vector<KeyOffsetPair> &matches) {
+    // Every match follows the first key that is not smaller than prefix contiguously
+    auto lo = lowerBoundInChunk(chunkStart, chunkHeader, prefix, 0);
+    for (size_t i = lo; i < chunkHeader.getNumKeysInChunk(); i++){
+        auto keyOffsetPair = keyOffsetPairAt(chunkStart, chunkHeader, i);
+        if (keyOffsetPair.key.compare(0, prefix.size(), prefix) != 0){
+            break;
+        }
+        matches.push_back(std::move(keyOffsetPair));
+    }
+}
+
+size_t SSFile::lowerBoundInChunk(SSFile::offset chunkStart, SSFile::KeyChunkHeader chunkHeader, const std::string &key, size_t lo) {
+    size_t hi = chunkHeader.getNumKeysInChunk();
+    if (!keyIndex.empty()){
+        auto pairLength = chunkHeader.keyOffsetPairLength();
+        auto padded = PaddedKeySearch::pad(key, chunkHeader.fixedKeySize);
+        return lo + PaddedKeySearch::lowerBound(keyIndexAt(chunkStart) + lo * pairLength, hi - lo, pairLength,
+                                                padded.data(), chunkHeader.fixedKeySize);
+    }
+
+    while (lo < hi){
+        size_t mid = lo + ((hi - lo) / 2);
+        file.seekg(chunkStart + static_cast<offset>(mid * chunkHeader.keyOffsetPairLength()));
+        if (readKeyOffsetPair(chunkHeader.fixedKeySize).key < key){
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+std::vector<std::pair<SSFile::offset, SSFile::KeyChunkHeader>> SSFile::readKeyChunkHeaders() {
+    if (!keyChunks.empty()){
+        return keyChunks;
+    }
+
+    std::vector<std::pair<offset, KeyChunkHeader>> chunks;
     file.seekg(header.keyFooterStart);
-    auto chunkHeader = readKeyChunkHeader();
+    while (true){
+        auto chunkHeader = readKeyChunkHeader();
+        offset chunkStart = file.tellg();
+        chunks.emplace_back(chunkStart, chunkHeader);
+        // The last chunk always holds keys up to the max key size, see SSFileCreator
+        if (chunkHeader.fixedKeySize >= SSTable::maxKeySize){
+            break;
+        }
+        file.seekg(chunkStart + static_cast<offset>(chunkHeader.length));
+    }
+
+    return chunks;
+}
+
+size_t SSFile::findChunkForKey(const std::string &key) const {
     /*
      * We are guaranteed to find a corresponding chunk, since we limit the max size of a key, and we make a
      * chunk that can fit keys up to the max size.
     */
-    while (key.size() > chunkHeader.fixedKeySize){
-        file.seekg(chunkHeader.length, std::ios::cur);
-        chunkHeader = readKeyChunkHeader();
+    size_t chunk = 0;
+    while (key.size() > keyChunks[chunk].second.fixedKeySize){
+        chunk++;
+    }
+
+    return chunk;
+}
+
+LearnedIndex::SearchWindow SSFile::searchWindow(size_t chunk, const std::string &key) const {
+    if (learnedIndexes.empty()){
+        return {0, keyChunks[chunk].second.getNumKeysInChunk()};
     }
 
-    return chunkHeader;
+    return learnedIndexes[chunk].predict(key);
 }
 
-SSFile::SSFileHeader SSFile::readSSFileHeader() {
+void SSFile::readLearnedIndexes() {
+    file.seekg(header.learnedIndexStart);
+    for (const auto &[chunkStart, chunkHeader] : keyChunks){
+        uint32_t commonPrefixLength, numSegments;
+        file.read(reinterpret_cast<char*>(&commonPrefixLength), sizeof(commonPrefixLength));
+        file.read(reinterpret_cast<char*>(&numSegments), sizeof(numSegments));
+        std::vector<LearnedIndex::Segment> segments(numSegments);
+        file.read(reinterpret_cast<char*>(segments.data()), static_cast<std::streamsize>(numSegments * sizeof(LearnedIndex::Segment)));
+        learnedIndexes.emplace_back(commonPrefixLength, std::move(segments), chunkHeader.getNumKeysInChunk());
+    }
+}
+
+SSFile::SSFileHeader SSFile::readSSFileHeader(const std::filesystem::path &path) {
     SSFileHeader ssFileHeader{};
-    file.read(reinterpret_cast<char*>(&ssFileHeader), sizeof(ssFileHeader));
+    try {
+        file.read(reinterpret_cast<char*>(&ssFileHeader), sizeof(ssFileHeader));
+    } catch (const std::ios::failure &) {
+        throw std::runtime_error(path.string() + " is too short to be an SSFile");
+    }
+    if (ssFileHeader.magic != SSTable::ssFileMagic){
+        throw std::runtime_error(path.string() + " is not an SSFile, or was written before SSFiles had a format version");
+    }
+    if (ssFileHeader.version != SSTable::ssFileFormatVersion){
+        throw std::runtime_error(path.string() + " has SSFile format version " + std::to_string(ssFileHeader.version) +
+                                 ", but only version " + std::to_string(SSTable::ssFileFormatVersion) + " can be read");
+    }
     return ssFileHeader;
 }
 
-BloomFilter SSFile::readBloomFilter(uint32_t bloomFilterLength) {
-    std::vector<uint8_t> bitset(bloomFilterLength);
-    file.read(reinterpret_cast<char*>(bitset.data()), bloomFilterLength);
-    return {SSTable::bloomFilterHashes, bitset};
+std::unique_ptr<KeyFilter> SSFile::readFilter(FilterType filterType, uint32_t filterLength) {
+    std::vector<uint8_t> bytes(filterLength);
+    file.read(reinterpret_cast<char*>(bytes.data()), filterLength);
+    switch (filterType) {
+        case FilterType::BLOOM:
+            return std::make_unique<BloomFilter>(SSTable::bloomFilterHashes, std::move(bytes));
+        case FilterType::XOR:
+            return std::make_unique<XorFilter>(bytes);
+        case FilterType::NONE:
+            break;
+    }
+
+    throw std::runtime_error("Unrecognized filter type " + std::to_string(static_cast<uint32_t>(filterType)));
 }
 
 SSFile::KeyChunkHeader SSFile::readKeyChunkHeader() {
@@ -110,10 +404,145 @@ SSFile::ValueHeader SSFile::readValueHeader() {
     return valueHeader;
 }
 
-DbValue SSFile::readValue(const ValueHeader &valueHeader) {
-    std::vector<char> data(valueHeader.dataLength, 0);
-    file.read(data.data(), valueHeader.dataLength);
-    return dbValueFromString(valueHeader.typeIndex, std::string(data.begin(), data.end()));
+SSFileRead SSFile::readEntry(offset valueOffset) {
+    file.seekg(valueOffset);
+    auto valueHeader = readValueHeader();
+    if (valueHeader.isEntryRemoved()){
+        return {KEY_TOMBSTONE};
+    }
+
+    std::string body(valueHeader.bodyLength(), '\0');
+    file.read(body.data(), static_cast<std::streamsize>(body.size()));
+    return decodeEntry(valueHeader, body);
+}
+
+SSFileRead SSFile::decodeEntry(const ValueHeader &header, const std::string &body) {
+    std::optional<uint64_t> expiresAt;
+    size_t dataStart = 0;
+    if (header.expires()){
+        uint64_t expiry;
+        std::memcpy(&expiry, body.data(), sizeof(expiry));
+        if (Expiry::hasPassed(expiry)){
+            return {KEY_TOMBSTONE};
+        }
+        expiresAt = expiry;
+        dataStart = sizeof(expiry);
+    }
+
+    auto type = header.isMergeOperand() ? KEY_MERGE_OPERAND : KEY_FOUND;
+    if (header.isValuePointer()){
+        ValuePointer pointer{};
+        std::memcpy(&pointer, body.data() + dataStart, sizeof(pointer));
+        return {type, std::nullopt, pointer, expiresAt};
+    }
+
+    return {type, dbValueFromString(header.valueType(), body.substr(dataStart)), std::nullopt, expiresAt};
+}
+
+std::vector<std::pair<SSFile::offset, size_t>> SSFile::findValueOffsetsBatched(const std::vector<std::string> &keys,
+                                                                              const std::vector<size_t> &candidates) {
+    struct Search {
+        size_t key;
+        size_t chunk;
+        size_t lo;
+        size_t hi;
+    };
+
+    std::vector<Search> searches;
+    for (auto key : candidates){
+        auto chunk = findChunkForKey(keys[key]);
+        auto window = searchWindow(chunk, keys[key]);
+        if (window.lo < window.hi){
+            searches.push_back({key, chunk, window.lo, window.hi});
+        }
+    }
+
+    // Every step reads the middle pair of each search that hasn't finished, all in one batch
+    std::vector<std::pair<offset, size_t>> found;
+    while (!searches.empty()){
+        // Searches over the same chunk start out probing the same pairs, which are only read once
+        std::map<offset, std::vector<char>> probes;
+        for (const auto &search : searches){
+            const auto &[chunkStart, chunkHeader] = keyChunks[search.chunk];
+            auto mid = search.lo + (search.hi - search.lo) / 2;
+            auto pos = chunkStart + static_cast<offset>(mid * chunkHeader.keyOffsetPairLength());
+            probes.try_emplace(pos, chunkHeader.keyOffsetPairLength());
+        }
+
+        std::vector<AsyncReader::Read> batch;
+        batch.reserve(probes.size());
+        for (auto &[pos, bytes] : probes){
+            batch.push_back({static_cast<uint64_t>(pos), bytes.size(), bytes.data()});
+        }
+        reader->readAll(batch);
+
+        std::vector<Search> unfinished;
+        for (auto search : searches){
+            const auto &[chunkStart, chunkHeader] = keyChunks[search.chunk];
+            auto mid = search.lo + (search.hi - search.lo) / 2;
+            const auto &pair = probes.at(chunkStart + static_cast<offset>(mid * chunkHeader.keyOffsetPairLength()));
+            std::string_view pairKey(pair.data(), strnlen(pair.data(), chunkHeader.fixedKeySize));
+            std::string_view key(keys[search.key]);
+            if (key == pairKey){
+                offset valueOffset;
+                std::memcpy(&valueOffset, pair.data() + chunkHeader.fixedKeySize, sizeof(offset));
+                found.emplace_back(valueOffset, search.key);
+                continue;
+            }
+
+            if (key < pairKey){
+                search.hi = mid;
+            } else {
+                search.lo = mid + 1;
+            }
+            if (search.lo < search.hi){
+                unfinished.push_back(search);
+            }
+        }
+        searches = std::move(unfinished);
+    }
+
+    return found;
+}
+
+std::vector<SSFileRead> SSFile::readEntries(const std::vector<offset> &valueOffsets) {
+    std::vector<SSFileRead> entries;
+    entries.reserve(valueOffsets.size());
+    if (!reader){
+        for (auto valueOffset : valueOffsets){
+            entries.push_back(readEntry(valueOffset));
+        }
+        return entries;
+    }
+
+    // The headers say how long each value is, so they are read first, then every value in a second batch
+    std::vector<ValueHeader> headers(valueOffsets.size());
+    std::vector<AsyncReader::Read> batch;
+    batch.reserve(valueOffsets.size());
+    for (size_t i = 0; i < valueOffsets.size(); i++){
+        batch.push_back({static_cast<uint64_t>(valueOffsets[i]), sizeof(ValueHeader), reinterpret_cast<char*>(&headers[i])});
+    }
+    reader->readAll(batch);
+
+    std::vector<std::string> data(valueOffsets.size());
+    batch.clear();
+    for (size_t i = 0; i < valueOffsets.size(); i++){
+        if (!headers[i].isEntryRemoved()){
+            data[i].resize(headers[i].bodyLength());
+            batch.push_back({static_cast<uint64_t>(valueOffsets[i]) + sizeof(ValueHeader), data[i].size(), data[i].data()});
+        }
+    }
+    reader->readAll(batch);
+
+    for (size_t i = 0; i < valueOffsets.size(); i++){
+        if (headers[i].isEntryRemoved()){
+            entries.push_back({KEY_TOMBSTONE});
+        } else {
+            entries.push_back(decodeEntry(headers[i], data[i]));
+        }
+    }
+
+    return entries;
 }
 
 SSFile::ValueHeader::ValueHeader(uint32_t dataLength, DbValueTypeIndex typeIndex) : dataLength(dataLength), typeIndex(typeIndex) {}
@@ -121,10 +550,34 @@ SSFile::ValueHeader::ValueHeader(uint32_t dataLength, DbValueTypeIndex typeIndex
 bool SSFile::ValueHeader::isEntryRemoved() const {
     return dataLength == 0;
 }
+bool SSFile::ValueHeader::isValuePointer() const {
+    return valueType() == valuePointerTypeIndex;
+}
+
+bool SSFile::ValueHeader::expires() const {
+    return (typeIndex & expiresFlag) != 0;
+}
+
+bool SSFile::ValueHeader::isMergeOperand() const {
+    return (typeIndex & mergeOperandFlag) != 0;
+}
+
+DbValueTypeIndex SSFile::ValueHeader::valueType() const {
+    return typeIndex & ~(expiresFlag | mergeOperandFlag);
+}
+
+size_t SSFile::ValueHeader::bodyLength() const {
+    return (expires() ? sizeof(uint64_t) : 0) + dataLength;
+}
+
 SSFile::ValueHeader SSFile::ValueHeader::TombstoneHeader() {
     return {0, 0};
 }
 
+SSFile::ValueHeader SSFile::ValueHeader::ValuePointerHeader() {
+    return {sizeof(ValuePointer), valuePointerTypeIndex};
+}
+
 SSFile::KeyChunkHeader::KeyChunkHeader(uint32_t fixedKeySize, uint32_t chunkLength)
         : fixedKeySize(fixedKeySize), length(chunkLength) {
     if (chunkLength % (fixedKeySize + sizeof(offset)) != 0){
@@ -147,15 +600,31 @@ size_t SSFile::KeyChunkHeader::getNumKeysInChunk() const {
 SSFile::KeyOffsetPair::KeyOffsetPair(std::string key, SSFile::offset pos) : key(std::move(key)), pos(pos) {}
 
 
-SSFile::SSFileHeader::SSFileHeader(uint32_t index, uint32_t bloomFilterLength,
-                                   uint32_t footerStart) : index(index),
-                                                           filterBits(bloomFilterLength),
+SSFile::SSFileHeader::SSFileHeader(uint32_t index, uint32_t filterStart, FilterType filterType,
+                                   uint32_t filterLength, PrefixExtractor prefixExtractor,
+                                   FilterType prefixFilterType, uint32_t prefixFilterLength,
+                                   uint32_t learnedIndexStart, uint32_t learnedIndexLength,
+                                   uint32_t footerStart) : magic(SSTable::ssFileMagic),
+                                                           version(SSTable::ssFileFormatVersion),
+                                                           index(index),
+                                                           filterStart(filterStart),
+                                                           filterType(filterType),
+                                                           filterLength(filterLength),
+                                                           prefixExtractor(prefixExtractor),
+                                                           prefixFilterType(prefixFilterType),
+                                                           prefixFilterLength(prefixFilterLength),
+                                                           learnedIndexStart(learnedIndexStart),
+                                                           learnedIndexLength(learnedIndexLength),
                                                            keyFooterStart(footerStart) {}
 
-bool SSFile::SSFileHeader::hasBloomFilter() const {
-    return filterBits > 0;
+bool SSFile::SSFileHeader::hasFilter() const {
+    return filterType != FilterType::NONE;
+}
+
+bool SSFile::SSFileHeader::hasLearnedIndex() const {
+    return learnedIndexLength > 0;
 }
 
-size_t SSFile::SSFileHeader::bloomFilterLength() const {
-    return filterBits / sizeof(BloomFilter::ByteType);
+bool SSFile::SSFileHeader::hasPrefixFilter() const {
+    return prefixExtractor.isEnabled() && prefixFilterType != FilterType::NONE;
 }
@@ -2,64 +2,150 @@
 #define DATAINTENSIVE_SSFILE_H
 
 #include <cstdint>
+#include <filesystem>
 #include <ios>
 #include <vector>
 #include <fstream>
+#include <memory>
 #include <optional>
 #include "../DatabaseEntry.h"
+#include "AsyncReader.h"
 #include "BloomFilter.h"
+#include "KeyFilter.h"
+#include "PrefixExtractor.h"
+#include "SSFileOptions.h"
+#include "EytzingerIndex.h"
+#include "LearnedIndex.h"
+#include "ValueLog.h"
 
 /*
  * Structure of an SSFile is as follows:
  *
  * SSFileHeader
- * [Optional] bloomFilterBits
- * Values
+ * Values (or ValuePointers into a ValueLog), each preceded by a ValueHeader and, for expiring entries, the expiry time
+ * [Optional] Filter (bloom or xor, see SSFileHeader::filterType)
+ * [Optional] Prefix filter
+ * [Optional] Learned index
  * [One or more] KeyChunk
  *
  * Where each KeyChunk is as follows:
  *
  * KeyChunkHeader
  * [One or more] (Key, value offset) pairs
+ *
+ * And the learned index holds, for each KeyChunk in the same order:
+ *
+ * Common prefix length, number of segments
+ * [One or more] LearnedIndex::Segment
  */
 
 enum SSFileReadType {
-    KEY_FOUND, KEY_TOMBSTONE, KEY_NOT_FOUND
+    KEY_FOUND, KEY_TOMBSTONE, KEY_NOT_FOUND,
+    /*
+     * The value is a merge operand (see MergeOperator), to be applied on top of the key's value in older files
+     */
+    KEY_MERGE_OPERAND
 };
 
+/*
+ * When the value was moved to a value log, type is KEY_FOUND (or KEY_MERGE_OPERAND), value is empty and valuePointer
+ * says where to read it.
+ * Entries inserted with a TTL carry their expiry time (see Expiry.h), and read as KEY_TOMBSTONE once it has passed,
+ * so they still shadow older versions of the key.
+ */
 struct SSFileRead {
     SSFileReadType type;
     std::optional<DbValue> value;
+    std::optional<ValuePointer> valuePointer;
+    std::optional<uint64_t> expiresAt;
 };
 
+class SSFileCursor;
+
 class SSFile {
 public:
 
     using offset = std::streamoff;
 
-    SSFile(std::fstream file);
+    explicit SSFile(const std::filesystem::path &path, const SSFileOptions &options = {});
+    SSFile(const SSFile&) = delete;
+    SSFile& operator=(const SSFile&) = delete;
+    ~SSFile();
     SSFileRead get(const std::string &key);
+    /*
+     * Looks up a batch of keys, which must be sorted. reads[i] corresponds to sortedKeys[i]. Keys are searched
+     * chunk by chunk, and values are read in the order they are laid out in the file. With an asynchronous
+     * options.readBackend, all searches advance together and each step's reads are issued as one batch.
+     */
+    std::vector<SSFileRead> multiGet(const std::vector<std::string> &sortedKeys);
+    /*
+     * Returns every entry (including tombstones) whose key starts with prefix, sorted by key. An empty prefix
+     * returns the whole file.
+     */
+    std::vector<std::pair<std::string, SSFileRead>> scanPrefix(const std::string &prefix);
+    /*
+     * False if the prefix filter guarantees no key in this file starts with prefix
+     */
+    bool canContainPrefix(const std::string &prefix) const;
+    /*
+     * Cursor over every entry in key order, for full scans such as exports. See SSFileCursor.
+     */
+    std::unique_ptr<SSFileCursor> newCursor(bool adaptiveReadahead = true) const;
     size_t getIndex() const;
 
 private:
 
     struct SSFileHeader {
         SSFileHeader() = default;
-        SSFileHeader(uint32_t index, uint32_t bloomFilterLength, uint32_t footerStart);
+        SSFileHeader(uint32_t index, uint32_t filterStart, FilterType filterType, uint32_t filterLength,
+                     PrefixExtractor prefixExtractor, FilterType prefixFilterType, uint32_t prefixFilterLength,
+                     uint32_t learnedIndexStart, uint32_t learnedIndexLength, uint32_t footerStart);
 
+        /*
+         * SSTable::ssFileMagic and SSTable::ssFileFormatVersion, checked before anything else is read
+         */
+        uint32_t magic;
+        uint32_t version;
         uint32_t index;
-        uint32_t filterBits;
+        /*
+         * The filters come after the values, so they can be built while the values are written. The prefix
+         * filter immediately follows the filter.
+         */
+        uint32_t filterStart;
+        FilterType filterType;
+        /*
+         * Length in bytes of the serialized filter
+         */
+        uint32_t filterLength;
+        /*
+         * The prefix filter holds prefixExtractor.extract(key) for every key in the file
+         */
+        PrefixExtractor prefixExtractor;
+        FilterType prefixFilterType;
+        uint32_t prefixFilterLength;
+        uint32_t learnedIndexStart;
+        uint32_t learnedIndexLength;
         uint32_t keyFooterStart;
 
-        bool hasBloomFilter() const;
-        size_t bloomFilterLength() const;
+        bool hasFilter() const;
+        bool hasPrefixFilter() const;
+        bool hasLearnedIndex() const;
     };
 
     struct ValueHeader {
         ValueHeader() = default;
         ValueHeader(uint32_t dataLength, DbValueTypeIndex typeIndex);
         static ValueHeader TombstoneHeader();
+        static ValueHeader ValuePointerHeader();
         bool isEntryRemoved() const;
+        bool isValuePointer() const;
+        bool expires() const;
+        bool isMergeOperand() const;
+        DbValueTypeIndex valueType() const;
+        /*
+         * Bytes following the header: the expiry time, if any, and the data
+         */
+        size_t bodyLength() const;
 
         /*
          * Note: dataLength = 0 when the entry is removed. This is an
@@ -69,9 +155,15 @@ private:
         uint32_t dataLength;
 
         /*
-         * Corresponds to the type index of DbValue's variant type
+         * Corresponds to the type index of DbValue's variant type, or valuePointerTypeIndex when the data
+         * is a ValuePointer. expiresFlag is set when a uint64_t expiry time sits between the header and the data,
+         * and mergeOperandFlag when the value is a merge operand.
          */
         DbValueTypeIndex typeIndex;
+
+        static constexpr DbValueTypeIndex valuePointerTypeIndex = std::variant_size_v<DbValue>;
+        static constexpr DbValueTypeIndex expiresFlag = DbValueTypeIndex(1) << (sizeof(DbValueTypeIndex) * 8 - 1);
+        static constexpr DbValueTypeIndex mergeOperandFlag = expiresFlag >> 1;
     };
 
     struct KeyChunkHeader {
@@ -94,19 +186,65 @@ private:
     };
 
     std::fstream file;
+    /*
+     * Only read with pread, by cursors
+     */
+    int fd = -1;
+    /*
+     * Only set when options.readBackend isn't SYNC
+     */
+    std::unique_ptr<AsyncReader> reader;
     SSFileHeader header{};
-    std::optional<BloomFilter> bloomFilter;
-
-    SSFileHeader readSSFileHeader();
-    BloomFilter readBloomFilter(uint32_t bloomFilterLength);
-    KeyChunkHeader moveToChunkForKey(const std::string &key);
+    std::unique_ptr<KeyFilter> filter;
+    std::unique_ptr<KeyFilter> prefixFilter;
+    /*
+     * File offset of each chunk's first key-offset pair, read when the file is opened
+     */
+    std::vector<std::pair<offset, KeyChunkHeader>> keyChunks;
+    /*
+     * Copy of the key chunks (everything from keyFooterStart to the end of the file), only populated when the
+     * key index is held in memory.
+     */
+    std::vector<char> keyIndex;
+    /*
+     * One per key chunk, only populated when the file has a learned index
+     */
+    std::vector<LearnedIndex> learnedIndexes;
+    /*
+     * One per key chunk, only populated when options.eytzingerKeyIndex is set
+     */
+    std::vector<EytzingerIndex> eytzingerIndexes;
+
+    SSFileHeader readSSFileHeader(const std::filesystem::path &path);
+    std::unique_ptr<KeyFilter> readFilter(FilterType filterType, uint32_t filterLength);
+    size_t findChunkForKey(const std::string &key) const;
+    LearnedIndex::SearchWindow searchWindow(size_t chunk, const std::string &key) const;
+    void readLearnedIndexes();
     KeyChunkHeader readKeyChunkHeader();
-    std::optional<offset> findValueOffset(offset chunkStart, KeyChunkHeader chunkHeader, const std::string &key);
+    void loadKeyIndex(bool buildEytzingerIndexes);
+    std::optional<offset> findValueOffset(size_t chunk, const std::string &key);
+    std::optional<offset> findValueOffsetInMemory(size_t chunk, const std::string &key) const;
+    const char* keyIndexAt(offset pos) const;
+    KeyOffsetPair keyOffsetPairAt(offset chunkStart, KeyChunkHeader chunkHeader, size_t index);
+    void findPrefixMatches(offset chunkStart, KeyChunkHeader chunkHeader, const std::string &prefix, std::vector<KeyOffsetPair> &matches);
+    size_t lowerBoundInChunk(offset chunkStart, KeyChunkHeader chunkHeader, const std::string &key, size_t lo);
+    std::vector<std::pair<offset, KeyChunkHeader>> readKeyChunkHeaders();
     KeyOffsetPair readKeyOffsetPair(size_t fixedKeySize);
-    DbValue readValue(const ValueHeader &header);
+    std::vector<std::pair<offset, size_t>> findValueOffsetsBatched(const std::vector<std::string> &keys, const std::vector<size_t> &candidates);
+    SSFileRead readEntry(offset valueOffset);
+    /*
+     * readEntry for every offset, batched when there is a reader
+     */
+    std::vector<SSFileRead> readEntries(const std::vector<offset> &valueOffsets);
     ValueHeader readValueHeader();
+    /*
+     * Entry described by a header that isn't a tombstone, given the header's body
+     */
+    static SSFileRead decodeEntry(const ValueHeader &header, const std::string &body);
 
     friend class SSFileCreator;
+    friend class SSFileWriter;
+    friend class SSFileCursor;
 };
 
 
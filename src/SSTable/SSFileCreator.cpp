@@ -1,155 +1,88 @@
 #include <iostream>
 #include "SSFileCreator.h"
+#include "Expiry.h"
 #include "fmt/format.h"
 
 
 std::unique_ptr<SSFile> SSFileCreator::newFile(const std::filesystem::path &directory, size_t index,
-                                               uint32_t filterBits,
-                                               const DbMemCache *memcache,  const std::set<std::string> &tombstones) {
-    auto filename = fmt::format(fmt::runtime(ssTableFilenameFormat), index);
-    std::fstream stream;
-    stream.exceptions(std::ios::badbit | std::ios::failbit);
-    auto dir = directory / filename;
-    stream.open(directory / filename, std::ios::out | std::ios::in | std::ios::trunc | std::ios::binary);
-    auto headerStart = writePlaceHolderSSFileHeader(&stream);
-    auto footerStart = writeToFile(&stream, memcache, tombstones, filterBits);
-    modifySSFileHeader(&stream, headerStart, SSFileHeader(index, filterBits, footerStart));
-    stream.seekg(0);
-    return std::make_unique<SSFile>(std::move(stream));
-}
-
-std::unique_ptr<SSFile> SSFileCreator::loadFile(const std::filesystem::path &file) {
-    if (!isFilenameSSTable(file)){
-        throw std::runtime_error("File " + file.string() + " is not a valid SSTable file");
-    }
-
-    std::fstream stream;
-    stream.exceptions(std::ios::badbit | std::ios::failbit);
-    stream.open(file, std::ios::in | std::ios::binary);
-    return std::make_unique<SSFile>(std::move(stream));
-}
-
-SSFileCreator::offset SSFileCreator::writeToFile(std::fstream *stream, const DbMemCache *memcache,
-                                                 const std::set<std::string> &tombstones, uint32_t filterBits) {
-    if (filterBits > 0){
-        auto bitset = BloomFilter(SSTable::bloomFilterHashes, filterBits, memcache, tombstones).getBitset();
-        stream->write(reinterpret_cast<const char*>(bitset.data()), bitset.size());
-    }
-
-    auto valueOffsets = writeValues(stream, memcache, tombstones);
-    auto keysBySize = groupByChunkKeySize(memcache, tombstones);
-    offset footerStart = writeKeyChunks(stream, keysBySize, valueOffsets);
-    return footerStart;
-}
-
-std::map<std::string, SSFileCreator::offset> SSFileCreator::writeValues(std::fstream *stream, const DbMemCache *memcache,
-                                                                        const std::set<std::string> &tombstones) {
-    std::map<std::string, offset> offsets;
-    auto tombstoneHeaderOffset = writeValueHeader(stream, ValueHeader::TombstoneHeader());
-    for (const auto& key : tombstones){
-        offsets[key] = tombstoneHeaderOffset;
-    }
-
-    memcache->traverseSorted([&](const std::string &key, const DbValue& value){
-        ValueHeader header(dbValueToString(value).size(), value.index());
-        offsets[key] = writeValueHeader(stream, header);
-        writeValue(stream, value);
-    });
-
-    return offsets;
-}
-
-SSFileCreator::offset SSFileCreator::writeKeyChunks(std::fstream *stream, const SSFileCreator::KeysBySize &keysBySize, const std::map<std::string, offset> &valueOffsets) {
-    auto prevOffset = stream->tellg();
-    for (const auto &it : keysBySize){
-        auto fixedKeySize = it.first;
-        auto keys = it.second;
-        auto keyOffsetPairSize = (fixedKeySize + sizeof(offset));
-        auto chunkSize = keyOffsetPairSize * keys.size();
-        auto chunkHeader = KeyChunkHeader(fixedKeySize, chunkSize);
-        writeChunkHeader(stream, chunkHeader);
-        for (const auto& key : keys){
-            writeKeyOffsetPair(stream, key, valueOffsets.at(key), fixedKeySize);
+                                               const SSFileOptions &options,
+                                               const DbMemCache *memcache,  const std::set<std::string> &tombstones,
+                                               ValueLog *valueLog, const std::unordered_map<std::string, uint64_t> &expiries,
+                                               const std::unordered_set<std::string> &mergeOperands) {
+    auto writer = newWriter(directory, index, options, valueLog);
+    // Both are already sorted, so merging them hands the writer every key in order without sorting again
+    auto tombstone = tombstones.begin();
+    for (const auto &[key, value] : *memcache){
+        for (; tombstone != tombstones.end() && *tombstone < key; tombstone++){
+            writer->addTombstone(*tombstone);
+        }
+        // The memcache entry is newer than a tombstone for the same key
+        if (tombstone != tombstones.end() && *tombstone == key){
+            tombstone++;
+        }
+        if (mergeOperands.find(key) != mergeOperands.end()){
+            writer->addMergeOperand(key, value);
+            continue;
         }
-    }
-    return prevOffset;
-}
 
-SSFileCreator::KeysBySize SSFileCreator::groupByChunkKeySize(const DbMemCache *memcache, const std::set<std::string>& tombstones) {
-    KeysBySize groups;
-    memcache->traverseSorted([&](const std::string &key, const DbValue& value) {
-        groups[findChunkKeySize(key)].push_back(key);
-    });
+        auto expiry = expiries.find(key);
+        std::optional<uint64_t> expiresAt;
+        if (expiry != expiries.end()){
+            if (Expiry::hasPassed(expiry->second)){
+                writer->addTombstone(key);
+                continue;
+            }
+            expiresAt = expiry->second;
+        }
 
-    for (const auto &key: tombstones){
-        groups[findChunkKeySize(key)].push_back(key);
+        DbValue rewritten;
+        auto decision = options.compactionFilter ? options.compactionFilter->filter(key, value, rewritten) : CompactionFilter::Decision::KEEP;
+        switch (decision) {
+            case CompactionFilter::Decision::KEEP:
+                writer->add(key, value, expiresAt);
+                break;
+            case CompactionFilter::Decision::DROP:
+                writer->addTombstone(key);
+                break;
+            case CompactionFilter::Decision::REWRITE:
+                writer->add(key, rewritten, expiresAt);
+                break;
+        }
     }
 
-    /*
-     * TODO: We should refactor memcache to use a standard cpp iterator so we don't have to sort here
-     */
-
-    for (const auto &keySize : chunkKeySizes){
-        std::sort(groups[keySize].begin(), groups[keySize].end());
+    for (; tombstone != tombstones.end(); tombstone++){
+        writer->addTombstone(*tombstone);
     }
 
-    return groups;
-}
-
-bool SSFileCreator::isFilenameSSTable(const std::filesystem::path &path) {
-    return std::regex_match(path.filename().string(), ssTableFilenameRegex);
-}
-
-SSFileCreator::offset SSFileCreator::writeValueHeader(std::fstream* stream, const ValueHeader &valueHeader) {
-    auto offset = stream->tellg();
-    stream->write(reinterpret_cast<const char*>(&valueHeader), sizeof(valueHeader));
-    return offset;
-}
-
-SSFileCreator::offset SSFileCreator::writeValue(std::fstream *stream, const DbValue& value) {
-    auto offset = stream->tellg();
-    auto str = dbValueToString(value);
-    stream->write(str.data(), str.size());
-    return offset;
+    return writer->finish();
 }
 
-SSFileCreator::offset SSFileCreator::writePlaceHolderSSFileHeader(std::fstream* stream) {
-    auto offset = stream->tellg();
-    SSFileHeader header{};
-    stream->write(reinterpret_cast<const char*>(&header), sizeof(header));
-    return offset;
+std::unique_ptr<SSFile> SSFileCreator::newFile(const std::filesystem::path &directory, size_t index,
+                                               uint32_t filterBits,
+                                               const DbMemCache *memcache,  const std::set<std::string> &tombstones) {
+    SSFileOptions options;
+    options.filterType = filterBits > 0 ? FilterType::BLOOM : FilterType::NONE;
+    options.bloomFilterBits = filterBits;
+    return newFile(directory, index, options, memcache, tombstones);
 }
 
-void SSFileCreator::modifySSFileHeader(std::fstream *stream, SSFileCreator::offset headerPos,
-                                       const SSFileCreator::SSFileHeader &header) {
-    auto oldOffset = stream->tellg();
-    stream->seekg(headerPos);
-    stream->write(reinterpret_cast<const char*>(&header), sizeof(header));
-    stream->seekg(oldOffset);
+std::unique_ptr<SSFileWriter> SSFileCreator::newWriter(const std::filesystem::path &directory, size_t index,
+                                                     const SSFileOptions &options, ValueLog *valueLog) {
+    return std::make_unique<SSFileWriter>(directory / filename(index), index, options, valueLog);
 }
 
-SSFileCreator::offset SSFileCreator::writeChunkHeader(std::fstream *stream, const KeyChunkHeader &header) {
-    auto prevOffset = stream->tellg();
-    stream->write(reinterpret_cast<const char*>(&header), sizeof(header));
-    return prevOffset;
+std::filesystem::path SSFileCreator::filename(size_t index) {
+    return fmt::format(fmt::runtime(ssTableFilenameFormat), index);
 }
 
-SSFileCreator::offset SSFileCreator::writeKeyOffsetPair(std::fstream *stream, std::string key, offset offset, size_t fixedKeySize) {
-    while (key.size() < fixedKeySize){
-        key += '\0';
+std::unique_ptr<SSFile> SSFileCreator::loadFile(const std::filesystem::path &file, const SSFileOptions &options) {
+    if (!isFilenameSSTable(file)){
+        throw std::runtime_error("File " + file.string() + " is not a valid SSTable file");
     }
 
-    auto prevOffset = stream->tellg();
-    stream->write(key.data(), key.size());
-    stream->write(reinterpret_cast<const char*>(&offset), sizeof(offset));
-    return prevOffset;
+    return std::make_unique<SSFile>(file, options);
 }
 
-size_t SSFileCreator::findChunkKeySize(const std::string &key) {
-    int i = 0;
-    while (i < chunkKeySizes.size() && key.size() > chunkKeySizes[i]){
-        i++;
-    }
-
-    return chunkKeySizes[i];
-}
\ No newline at end of file
+bool SSFileCreator::isFilenameSSTable(const std::filesystem::path &path) {
+    return std::regex_match(path.filename().string(), ssTableFilenameRegex);
+}
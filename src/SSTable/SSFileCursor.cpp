@@ -0,0 +1,77 @@
+#include "SSFileCursor.h"
+#include <algorithm>
+#include <cstring>
+
+SSFileCursor::SSFileCursor(const SSFile &file, bool adaptiveReadahead)
+        : values(file.fd, file.header.filterStart, adaptiveReadahead) {
+    for (const auto &[chunkStart, chunkHeader] : file.keyChunks){
+        auto start = static_cast<uint64_t>(chunkStart);
+        chunks.push_back({SequentialReader(file.fd, start + chunkHeader.length, adaptiveReadahead),
+                          chunkHeader.fixedKeySize, start, start + chunkHeader.length});
+    }
+
+    for (size_t i = 0; i < chunks.size(); i++){
+        if (chunks[i].advance()){
+            liveChunks.push_back(i);
+        }
+    }
+    load();
+}
+
+bool SSFileCursor::valid() const {
+    return !liveChunks.empty();
+}
+
+void SSFileCursor::next() {
+    if (!chunks[current].advance()){
+        liveChunks.erase(std::find(liveChunks.begin(), liveChunks.end(), current));
+    }
+    load();
+}
+
+const std::string &SSFileCursor::key() const {
+    return chunks[current].key;
+}
+
+const SSFileRead &SSFileCursor::read() const {
+    return currentRead;
+}
+
+void SSFileCursor::load() {
+    if (liveChunks.empty()){
+        return;
+    }
+
+    // There are only a handful of chunks, so a linear scan finds the smallest key faster than a heap would
+    current = liveChunks.front();
+    for (auto chunk : liveChunks){
+        if (chunks[chunk].key < chunks[current].key){
+            current = chunk;
+        }
+    }
+
+    auto valueOffset = static_cast<uint64_t>(chunks[current].valueOffset);
+    ValueHeader header{};
+    values.read(valueOffset, sizeof(header), reinterpret_cast<char*>(&header));
+    if (header.isEntryRemoved()){
+        currentRead = {KEY_TOMBSTONE};
+        return;
+    }
+
+    std::string body(header.bodyLength(), '\0');
+    values.read(valueOffset + sizeof(header), body.size(), body.data());
+    currentRead = SSFile::decodeEntry(header, body);
+}
+
+bool SSFileCursor::ChunkStream::advance() {
+    if (pos >= end){
+        return false;
+    }
+
+    std::string pair(fixedKeySize + sizeof(offset), '\0');
+    reader.read(pos, pair.size(), pair.data());
+    key.assign(pair.data(), strnlen(pair.data(), fixedKeySize));
+    std::memcpy(&valueOffset, pair.data() + fixedKeySize, sizeof(offset));
+    pos += pair.size();
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef DATAINTENSIVE_SSFILECURSOR_H
+#define DATAINTENSIVE_SSFILECURSOR_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "SSFile.h"
+#include "SequentialReader.h"
+
+/*
+ * Walks every entry of an SSFile in key order, tombstones included. Keys are split across chunks by length, so
+ * the cursor merges one stream per chunk, and reads the values in between from a stream of their own. Values are
+ * laid out in key order, so all streams are read front to back, and with adaptive readahead each of them grows
+ * its reads until a full scan runs at the speed of large sequential reads.
+ *
+ * A cursor must not outlive its file. Cursors don't share any state with the file's lookups, so a cursor can be
+ * used while another thread calls get on the same file.
+ */
+class SSFileCursor {
+public:
+    SSFileCursor(const SSFile &file, bool adaptiveReadahead);
+    bool valid() const;
+    void next();
+    const std::string& key() const;
+    /*
+     * Like the result of SSFile::get for key()
+     */
+    const SSFileRead& read() const;
+
+private:
+    using offset = SSFile::offset;
+    using ValueHeader = SSFile::ValueHeader;
+
+    struct ChunkStream {
+        SequentialReader reader;
+        size_t fixedKeySize;
+        uint64_t pos;
+        uint64_t end;
+        std::string key;
+        offset valueOffset = 0;
+
+        /*
+         * Loads the next key of the chunk, returns false once the chunk is exhausted
+         */
+        bool advance();
+    };
+
+    std::vector<ChunkStream> chunks;
+    /*
+     * Chunks with keys left
+     */
+    std::vector<size_t> liveChunks;
+    SequentialReader values;
+    size_t current = 0;
+    SSFileRead currentRead{KEY_NOT_FOUND};
+
+    void load();
+};
+
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef DATAINTENSIVE_SSFILEOPTIONS_H
+#define DATAINTENSIVE_SSFILEOPTIONS_H
+
+#include <cstdint>
+#include <memory>
+#include "AsyncReader.h"
+#include "CompactionFilter.h"
+#include "MergeOperator.h"
+#include "KeyFilter.h"
+#include "PrefixExtractor.h"
+#include "SSTableParams.h"
+
+/*
+ * Options for how SSFiles are written and read. Options that change the on-disk format are recorded in the
+ * file itself, so files written with different options can be read back together.
+ */
+struct SSFileOptions {
+    FilterType filterType = FilterType::NONE;
+    /*
+     * Only used by bloom filters. Xor filters are sized from the number of keys in the file.
+     */
+    uint32_t bloomFilterBits = SSTable::bloomFilterBits;
+    /*
+     * When enabled, a second filter holding the prefix of every key is stored, so prefix scans can skip files
+     * that have no key with the scanned prefix.
+     */
+    PrefixExtractor prefixExtractor;
+    FilterType prefixFilterType = FilterType::BLOOM;
+    /*
+     * Keep a copy of the key chunks in memory when the file is opened, so lookups only read the value from disk.
+     */
+    bool keyIndexInMemory = false;
+    /*
+     * Also keep an Eytzinger ordered copy of each in-memory key chunk for point lookups, trading memory for fewer
+     * cache misses per lookup. Implies keyIndexInMemory.
+     */
+    bool eytzingerKeyIndex = false;
+    /*
+     * Store a piecewise linear model of each KeyChunk, so lookups only binary search a small window around the
+     * predicted position of the key. See LearnedIndex.
+     */
+    bool learnedIndex = false;
+    uint32_t learnedIndexMaxError = SSTable::learnedIndexMaxError;
+    /*
+     * Values whose serialized size is at least this many bytes are appended to a ValueLog, and the SSFile only
+     * stores a ValuePointer to them. 0 keeps every value in the SSFile.
+     */
+    uint32_t valueLogThreshold = 0;
+    uint64_t valueLogFileSize = SSTable::maxValueLogFileSize;
+    /*
+     * The memcache is flushed once its memoryUsage() reaches this many bytes, so files come out close to the same
+     * size whatever the size of the values. 0 flushes every SSTable::maxMemcacheSize entries instead.
+     */
+    uint64_t memcacheFlushBytes = 0;
+    /*
+     * Threads that encode a file's entries while it is being written: values, filter hashes and key chunks are
+     * encoded in blocks of about SSTable::encodeBlockSize bytes, then written to the file in order. 1 encodes
+     * every entry on the writing thread.
+     */
+    unsigned int encodeThreads = 1;
+    /*
+     * How multiGet and scanPrefix read the file. With IO_URING or THREAD_POOL, multiGet runs the binary search
+     * of every key in lockstep and reads the probes of each step, and then all values, as one batch, so the
+     * disk sees many reads at once instead of one. Single key gets always read one at a time.
+     */
+    ReadBackend readBackend = ReadBackend::SYNC;
+    /*
+     * Write files with O_DIRECT, so flushes and ingests don't evict the pages foreground reads depend on from the
+     * page cache. On file systems without O_DIRECT, files are synced and dropped from the page cache once
+     * written instead. Reads always go through the page cache, since there is no block cache to replace it.
+     */
+    bool directWrites = false;
+    /*
+     * Called for every entry written by a memcache flush or by SSTableDb::compact(). Not called by ingests.
+     */
+    std::shared_ptr<const CompactionFilter> compactionFilter;
+    /*
+     * Combines the operands passed to SSTableDb::merge. Must be set to merge, and to read a database holding merge
+     * records, always with the same operator.
+     */
+    std::shared_ptr<const MergeOperator> mergeOperator;
+};
+
+#endif
@@ -0,0 +1,458 @@
+#include "SSFileWriter.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+#include "XorFilter.h"
+
+SSFileWriter::SSFileWriter(const std::filesystem::path &file, size_t index, const SSFileOptions &options,
+                           ValueLog *valueLog) : path(file), index(index), options(options), valueLog(valueLog),
+                                                 buffer(static_cast<char*>(std::aligned_alloc(SSTable::writeBufferAlignment, SSTable::writeBufferSize)), &std::free) {
+    if (!buffer){
+        throw std::bad_alloc();
+    }
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    if (options.directWrites){
+        // Some file systems, such as tmpfs, don't support O_DIRECT. Those files are dropped from the page cache
+        // by closeFile instead.
+        fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+        direct = fd >= 0;
+    }
+    if (fd < 0){
+        fd = ::open(path.c_str(), flags, 0644);
+    }
+    if (fd < 0){
+        throw std::system_error(errno, std::generic_category(), "Couldn't create " + path.string());
+    }
+    for (auto keySize : chunkKeySizes){
+        chunks.push_back({keySize});
+    }
+    block = newBlock();
+
+    if (options.filterType == FilterType::BLOOM){
+        bloomFilter = std::make_unique<BloomFilter>(SSTable::bloomFilterHashes, options.bloomFilterBits);
+    }
+
+    // Placeholder, the real header is written by finish once every offset is known
+    SSFileHeader header{};
+    append(&header, sizeof(header));
+}
+
+void SSFileWriter::add(const std::string &key, const DbValue &value, std::optional<uint64_t> expiresAt) {
+    addEntry(key, &value, nullptr, expiresAt);
+}
+
+void SSFileWriter::addValuePointer(const std::string &key, const ValuePointer &pointer, std::optional<uint64_t> expiresAt) {
+    addEntry(key, nullptr, &pointer, expiresAt);
+}
+
+void SSFileWriter::addMergeOperand(const std::string &key, const DbValue &operand) {
+    addEntry(key, &operand, nullptr, std::nullopt, true);
+}
+
+void SSFileWriter::addTombstone(const std::string &key) {
+    addEntry(key, nullptr, nullptr, std::nullopt);
+}
+
+void SSFileWriter::addEntry(const std::string &key, const DbValue *value, const ValuePointer *pointer,
+                            std::optional<uint64_t> expiresAt, bool mergeOperand) {
+    checkKey(key);
+    if (options.encodeThreads <= 1){
+        encode(block, key, value, pointer, expiresAt, mergeOperand);
+        if (block.size >= SSTable::encodeBlockSize){
+            assemble(block);
+            block = newBlock();
+        }
+        return;
+    }
+
+    pendingBytes += key.size() + (value ? sizeof(DbValue) + approximateHeapSize(*value) : 0) + (pointer ? sizeof(ValuePointer) : 0);
+    pending.push_back({key, value ? std::optional<DbValue>(*value) : std::nullopt,
+                       pointer ? std::optional<ValuePointer>(*pointer) : std::nullopt, expiresAt, mergeOperand});
+    if (pendingBytes >= SSTable::encodeBlockSize){
+        dispatchPending();
+    }
+}
+
+void SSFileWriter::checkKey(const std::string &key) {
+    if (finished){
+        throw std::runtime_error("Can't add key " + key + " to a finished SSFile");
+    }
+    if (key.size() > SSTable::maxKeySize){
+        throw std::runtime_error("Key " + key + " is longer than the max key size " + std::to_string(SSTable::maxKeySize));
+    }
+    if (entries > 0 && key <= lastKey){
+        throw std::runtime_error("Keys must be added in increasing order, " + key + " was added after " + lastKey);
+    }
+
+    lastKey = key;
+    entries++;
+}
+
+SSFileWriter::EncodedBlock SSFileWriter::newBlock() const {
+    EncodedBlock encoded;
+    for (auto keySize : chunkKeySizes){
+        encoded.chunks.push_back({keySize});
+    }
+
+    return encoded;
+}
+
+void SSFileWriter::encode(EncodedBlock &target, const std::string &key, const DbValue *value, const ValuePointer *pointer,
+                          std::optional<uint64_t> expiresAt, bool mergeOperand) const {
+    auto &bytes = target.bytes;
+    auto appendBytes = [&bytes](const void *data, size_t length){
+        auto begin = static_cast<const char*>(data);
+        bytes.insert(bytes.end(), begin, begin + length);
+    };
+
+    auto appendHeader = [&](ValueHeader header){
+        if (expiresAt.has_value()){
+            header.typeIndex |= ValueHeader::expiresFlag;
+        }
+        if (mergeOperand){
+            header.typeIndex |= ValueHeader::mergeOperandFlag;
+        }
+        appendBytes(&header, sizeof(header));
+        if (expiresAt.has_value()){
+            appendBytes(&expiresAt.value(), sizeof(uint64_t));
+        }
+    };
+
+    offset valueOffset = bytes.size();
+    if (pointer){
+        appendHeader(ValueHeader::ValuePointerHeader());
+        appendBytes(pointer, sizeof(ValuePointer));
+        target.size += sizeof(ValuePointer);
+    } else if (!value){
+        if (!target.tombstoneHeaderOffset.has_value()){
+            target.tombstoneHeaderOffset = valueOffset;
+            auto header = ValueHeader::TombstoneHeader();
+            appendBytes(&header, sizeof(header));
+        }
+        valueOffset = target.tombstoneHeaderOffset.value();
+    } else {
+        auto data = dbValueToString(*value);
+        // Garbage collection moves live values by inserting them again, which an operand can't be
+        if (valueLog && options.valueLogThreshold > 0 && data.size() >= options.valueLogThreshold && !mergeOperand){
+            appendHeader(ValueHeader::ValuePointerHeader());
+            // Filled in by assemble, once the value has been appended to the log
+            target.loggedValues.emplace_back(bytes.size(), key, *value);
+            bytes.resize(bytes.size() + sizeof(ValuePointer));
+        } else {
+            appendHeader(ValueHeader(data.size(), value->index()));
+            appendBytes(data.data(), data.size());
+        }
+        target.size += data.size();
+    }
+    target.size += key.size();
+
+    auto chunk = std::find_if(target.chunks.begin(), target.chunks.end(), [&key](const KeyChunk &chunk){
+        return key.size() <= chunk.fixedKeySize;
+    });
+    auto &pairs = chunk->pairs;
+    auto pairStart = pairs.size();
+    // resize zero fills, which is the padding after the key
+    pairs.resize(pairStart + chunk->fixedKeySize + sizeof(offset));
+    std::memcpy(pairs.data() + pairStart, key.data(), key.size());
+    std::memcpy(pairs.data() + pairStart + chunk->fixedKeySize, &valueOffset, sizeof(valueOffset));
+    chunk->numKeys++;
+
+    if (bloomFilter){
+        auto bits = bloomFilter->getBitsetIndices(key);
+        target.bloomBits.insert(target.bloomBits.end(), bits.begin(), bits.end());
+    } else if (options.filterType == FilterType::XOR){
+        target.xorKeyHashes.push_back(XorFilter::hashKey(key));
+    }
+
+    if (options.prefixExtractor.isEnabled()){
+        auto prefix = options.prefixExtractor.extract(key);
+        if (prefix.has_value() && (target.prefixes.empty() || target.prefixes.back() != prefix.value())){
+            target.prefixes.push_back(std::move(prefix.value()));
+        }
+    }
+}
+
+SSFileWriter::EncodedBlock SSFileWriter::encodeAll(std::vector<PendingEntry> entries) const {
+    auto encoded = newBlock();
+    for (const auto &entry : entries){
+        encode(encoded, entry.key, entry.value.has_value() ? &entry.value.value() : nullptr,
+               entry.pointer.has_value() ? &entry.pointer.value() : nullptr, entry.expiresAt, entry.mergeOperand);
+    }
+
+    return encoded;
+}
+
+void SSFileWriter::dispatchPending() {
+    // At most one block per encode thread is held in memory
+    while (encoding.size() >= options.encodeThreads){
+        assembleOldest();
+    }
+
+    encoding.push_back(std::async(std::launch::async, &SSFileWriter::encodeAll, this, std::move(pending)));
+    pending.clear();
+    pendingBytes = 0;
+}
+
+void SSFileWriter::assembleOldest() {
+    auto encoded = encoding.front().get();
+    encoding.pop_front();
+    assemble(encoded);
+}
+
+void SSFileWriter::assemble(EncodedBlock &encoded) {
+    auto base = position;
+    for (auto &[pointerOffset, key, value] : encoded.loggedValues){
+        auto pointer = valueLog->append(key, value);
+        std::memcpy(encoded.bytes.data() + pointerOffset, &pointer, sizeof(pointer));
+    }
+    append(encoded.bytes.data(), encoded.bytes.size());
+
+    for (size_t i = 0; i < chunks.size(); i++){
+        auto &from = encoded.chunks[i];
+        auto pairLength = from.fixedKeySize + sizeof(offset);
+        for (size_t pair = 0; pair < from.numKeys; pair++){
+            auto offsetBytes = from.pairs.data() + pair * pairLength + from.fixedKeySize;
+            offset valueOffset;
+            std::memcpy(&valueOffset, offsetBytes, sizeof(valueOffset));
+            valueOffset += base;
+            std::memcpy(offsetBytes, &valueOffset, sizeof(valueOffset));
+        }
+        chunks[i].pairs.insert(chunks[i].pairs.end(), from.pairs.begin(), from.pairs.end());
+        chunks[i].numKeys += from.numKeys;
+    }
+
+    if (bloomFilter){
+        bloomFilter->addBitsetIndices(encoded.bloomBits);
+    }
+    xorKeyHashes.insert(xorKeyHashes.end(), encoded.xorKeyHashes.begin(), encoded.xorKeyHashes.end());
+    for (auto &prefix : encoded.prefixes){
+        if (prefixes.empty() || prefixes.back() != prefix){
+            prefixes.push_back(std::move(prefix));
+        }
+    }
+}
+
+std::unique_ptr<SSFile> SSFileWriter::finish() {
+    if (finished){
+        throw std::runtime_error("SSFile " + path.string() + " was already finished");
+    }
+    finished = true;
+
+    if (options.encodeThreads <= 1){
+        assemble(block);
+    } else {
+        if (!pending.empty()){
+            dispatchPending();
+        }
+        while (!encoding.empty()){
+            assembleOldest();
+        }
+    }
+
+    // The file must not point at records that could be lost
+    if (valueLog){
+        valueLog->sync();
+    }
+
+    auto filterStart = position;
+    auto filter = finishFilter();
+    auto filterLength = appendFilter(filter.get());
+    auto prefixFilter = finishPrefixFilter();
+    auto prefixFilterLength = appendFilter(prefixFilter.get());
+    auto learnedIndexStart = position;
+    if (options.learnedIndex){
+        appendLearnedIndex();
+    }
+    auto learnedIndexLength = position - learnedIndexStart;
+    auto footerStart = position;
+    // The header holds 32 bit offsets, and every other offset and length in it is below footerStart
+    if (footerStart > std::numeric_limits<uint32_t>::max()){
+        throw std::runtime_error("SSFile " + path.string() + " is too large, its key chunks would start at byte " +
+                                 std::to_string(footerStart) + " but the header only holds 32 bit offsets");
+    }
+    appendKeyChunks();
+
+    auto prefixFilterType = prefixFilter ? options.prefixFilterType : FilterType::NONE;
+    SSFileHeader header(index, filterStart, options.filterType, filterLength, options.prefixExtractor, prefixFilterType,
+                        prefixFilterLength, learnedIndexStart, learnedIndexLength, footerStart);
+    if (flushed == 0){
+        // Nothing was written yet, so the header goes out with the rest of the file
+        std::memcpy(buffer.get(), &header, sizeof(header));
+        flushBuffer();
+    } else if (direct){
+        flushBuffer();
+        std::memcpy(firstBlock.get(), &header, sizeof(header));
+        writeAt(firstBlock.get(), SSTable::writeBufferAlignment, 0);
+    } else {
+        flushBuffer();
+        writeAt(reinterpret_cast<const char*>(&header), sizeof(header), 0);
+    }
+    closeFile();
+
+    return std::make_unique<SSFile>(path, options);
+}
+
+size_t SSFileWriter::numEntries() const {
+    return entries;
+}
+
+uint64_t SSFileWriter::fileSize() const {
+    return position + block.bytes.size() + pendingBytes;
+}
+
+void SSFileWriter::append(const void *data, size_t length) {
+    auto bytes = static_cast<const char*>(data);
+    position += static_cast<offset>(length);
+    while (length > 0){
+        if (bufferUsed == SSTable::writeBufferSize){
+            flushBuffer();
+        }
+
+        auto copied = std::min(length, SSTable::writeBufferSize - bufferUsed);
+        std::memcpy(buffer.get() + bufferUsed, bytes, copied);
+        bufferUsed += copied;
+        bytes += copied;
+        length -= copied;
+    }
+}
+
+SSFileWriter::~SSFileWriter() {
+    if (fd >= 0){
+        close(fd);
+    }
+}
+
+void SSFileWriter::flushBuffer() {
+    auto length = bufferUsed;
+    if (direct){
+        // Only the last flush can end partway through a block. It is padded, and closeFile truncates the padding.
+        auto alignment = SSTable::writeBufferAlignment;
+        auto alignedLength = (length + alignment - 1) / alignment * alignment;
+        std::memset(buffer.get() + length, 0, alignedLength - length);
+        if (flushed == 0){
+            firstBlock.reset(static_cast<char*>(std::aligned_alloc(alignment, alignment)));
+            if (!firstBlock){
+                throw std::bad_alloc();
+            }
+            std::memcpy(firstBlock.get(), buffer.get(), alignment);
+        }
+        length = alignedLength;
+    }
+
+    writeAt(buffer.get(), length, flushed);
+    flushed += static_cast<offset>(bufferUsed);
+    bufferUsed = 0;
+}
+
+void SSFileWriter::writeAt(const char *data, size_t length, offset pos) {
+    while (length > 0){
+        auto written = ::pwrite(fd, data, length, pos);
+        if (written < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "Couldn't write to " + path.string());
+        }
+
+        data += written;
+        length -= written;
+        pos += written;
+    }
+}
+
+void SSFileWriter::closeFile() {
+    if (direct && ftruncate(fd, position) != 0){
+        throw std::system_error(errno, std::generic_category(), "Couldn't truncate " + path.string());
+    }
+    if (options.directWrites && !direct){
+        // Pages can only be dropped once they are clean
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+
+    close(fd);
+    fd = -1;
+}
+
+std::unique_ptr<KeyFilter> SSFileWriter::finishFilter() {
+    switch (options.filterType) {
+        case FilterType::NONE:
+            return nullptr;
+        case FilterType::BLOOM:
+            return std::move(bloomFilter);
+        case FilterType::XOR:
+            return std::make_unique<XorFilter>(std::move(xorKeyHashes));
+    }
+
+    throw std::runtime_error("Unrecognized filter type " + std::to_string(static_cast<uint32_t>(options.filterType)));
+}
+
+std::unique_ptr<KeyFilter> SSFileWriter::finishPrefixFilter() {
+    if (!options.prefixExtractor.isEnabled()){
+        return nullptr;
+    }
+
+    /*
+     * Tombstones must be included, otherwise a scan could skip the file holding a tombstone and return the deleted
+     * entry from an older file.
+     */
+    std::sort(prefixes.begin(), prefixes.end());
+    prefixes.erase(std::unique(prefixes.begin(), prefixes.end()), prefixes.end());
+    switch (options.prefixFilterType) {
+        case FilterType::NONE:
+            return nullptr;
+        case FilterType::BLOOM:
+            return std::make_unique<BloomFilter>(SSTable::bloomFilterHashes, options.bloomFilterBits, prefixes);
+        case FilterType::XOR:
+            return std::make_unique<XorFilter>(prefixes);
+    }
+
+    throw std::runtime_error("Unrecognized filter type " + std::to_string(static_cast<uint32_t>(options.prefixFilterType)));
+}
+
+uint32_t SSFileWriter::appendFilter(const KeyFilter *filter) {
+    if (!filter){
+        return 0;
+    }
+
+    auto bytes = filter->serialize();
+    append(bytes.data(), bytes.size());
+    return bytes.size();
+}
+
+void SSFileWriter::appendLearnedIndex() {
+    // One model per chunk, in the same order appendKeyChunks writes the chunks
+    for (const auto &chunk : chunks){
+        auto pairLength = chunk.fixedKeySize + sizeof(offset);
+        std::vector<std::string_view> keys;
+        keys.reserve(chunk.numKeys);
+        for (size_t i = 0; i < chunk.numKeys; i++){
+            auto key = chunk.pairs.data() + i * pairLength;
+            keys.emplace_back(key, strnlen(key, chunk.fixedKeySize));
+        }
+
+        LearnedIndex learnedIndex(keys, options.learnedIndexMaxError);
+        uint32_t commonPrefixLength = learnedIndex.getCommonPrefixLength();
+        const auto &segments = learnedIndex.getSegments();
+        uint32_t numSegments = segments.size();
+        append(&commonPrefixLength, sizeof(commonPrefixLength));
+        append(&numSegments, sizeof(numSegments));
+        append(segments.data(), numSegments * sizeof(LearnedIndex::Segment));
+    }
+}
+
+void SSFileWriter::appendKeyChunks() {
+    // Every chunk is written, even empty ones, so the last chunk always holds the longest keys
+    for (auto &chunk : chunks){
+        KeyChunkHeader header(chunk.fixedKeySize, chunk.pairs.size());
+        append(&header, sizeof(header));
+        append(chunk.pairs.data(), chunk.pairs.size());
+        // The chunk is on its way to disk, give its memory back before copying the next one
+        std::vector<char>().swap(chunk.pairs);
+    }
+}
@@ -0,0 +1,196 @@
+#ifndef DATAINTENSIVE_SSFILEWRITER_H
+#define DATAINTENSIVE_SSFILEWRITER_H
+
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "../DatabaseEntry.h"
+#include "BloomFilter.h"
+#include "MemCache.h"
+#include "SSFile.h"
+#include "SSFileOptions.h"
+#include "SSTableParams.h"
+#include "ValueLog.h"
+
+/*
+ * Builds an SSFile from entries handed over once, in sorted order. Values are copied straight into an aligned
+ * write buffer, and the only per key state kept until finish() is the key chunks themselves: each key is padded
+ * into its chunk next to its value offset, exactly as it will be written. Filters are fed as keys arrive (xor
+ * filters keep an 8 byte hash per key until they can be built), so the writer never holds a second copy of the
+ * keys and never sorts.
+ *
+ * Entries are encoded in blocks whose offsets are relative to the start of the block, and blocks are assembled
+ * into the file in the order their entries were added. With options.encodeThreads > 1, added entries are copied
+ * into a block that is encoded by another thread once it is full, so hashing and encoding run in parallel while
+ * the writing thread only assembles finished blocks. Values bound for the value log are appended during assembly,
+ * so the log still receives them in key order from a single thread.
+ */
+class SSFileWriter {
+public:
+    /*
+     * Values at least options.valueLogThreshold bytes long are appended to valueLog instead, when one is given.
+     */
+    SSFileWriter(const std::filesystem::path &file, size_t index, const SSFileOptions &options, ValueLog *valueLog = nullptr);
+    SSFileWriter(const SSFileWriter&) = delete;
+    SSFileWriter& operator=(const SSFileWriter&) = delete;
+    ~SSFileWriter();
+
+    /*
+     * Keys must be added in strictly increasing order, across add, addValuePointer and addTombstone. expiresAt
+     * is the entry's expiry time for entries inserted with a TTL (see Expiry.h).
+     */
+    void add(const std::string &key, const DbValue &value, std::optional<uint64_t> expiresAt = std::nullopt);
+    /*
+     * Adds an entry whose value is already in the value log, such as one carried over by a compaction
+     */
+    void addValuePointer(const std::string &key, const ValuePointer &pointer, std::optional<uint64_t> expiresAt = std::nullopt);
+    /*
+     * Adds a merge operand, which reads as KEY_MERGE_OPERAND. Operands always stay in the file, even when a value
+     * log is used.
+     */
+    void addMergeOperand(const std::string &key, const DbValue &operand);
+    void addTombstone(const std::string &key);
+    /*
+     * Writes the filters, the learned index and the key chunks, then reopens the finished file for reading. The
+     * writer can't be used afterwards.
+     */
+    std::unique_ptr<SSFile> finish();
+    size_t numEntries() const;
+    /*
+     * Approximate bytes written so far, not counting the filters and key chunks finish() still has to write, nor
+     * blocks that are still being encoded
+     */
+    uint64_t fileSize() const;
+
+private:
+
+    using offset = SSFile::offset;
+    using SSFileHeader = SSFile::SSFileHeader;
+    using ValueHeader = SSFile::ValueHeader;
+    using KeyChunkHeader = SSFile::KeyChunkHeader;
+
+    /*
+     * (Key, value offset) pairs of one chunk, laid out as they are written to the file
+     */
+    struct KeyChunk {
+        size_t fixedKeySize;
+        std::vector<char> pairs;
+        size_t numKeys = 0;
+    };
+
+    static_assert(sizeof(SSFileHeader) <= SSTable::writeBufferAlignment, "The header must fit in the first block, which finish rewrites");
+
+    inline static const std::vector<size_t> chunkKeySizes = {8, 16, 32, 64, 128, 256, 512, SSTable::maxKeySize};
+    static_assert(SSTable::maxKeySize > 512, "Max key size must be larger than the previous key chunk size. Adjust key chunk sizes if changing max key size.");
+
+    /*
+     * Entries encoded apart from the rest of the file. Offsets in bytes and in the key chunks are relative to the
+     * start of the block until it is assembled.
+     */
+    struct EncodedBlock {
+        std::vector<char> bytes;
+        std::vector<KeyChunk> chunks;
+        /*
+         * Bytes of keys and values encoded into the block
+         */
+        size_t size = 0;
+        /*
+         * Every tombstone in the block points at the same header, written the first time one is added
+         */
+        std::optional<offset> tombstoneHeaderOffset;
+        std::vector<unsigned long long> bloomBits;
+        std::vector<uint64_t> xorKeyHashes;
+        std::vector<std::string> prefixes;
+        /*
+         * Values bound for the value log, with the offset of the ValuePointer to fill in once they are appended
+         */
+        std::vector<std::tuple<offset, std::string, DbValue>> loggedValues;
+    };
+
+    /*
+     * An entry waiting for an encode thread. Tombstones have neither a value nor a pointer.
+     */
+    struct PendingEntry {
+        std::string key;
+        std::optional<DbValue> value;
+        std::optional<ValuePointer> pointer;
+        std::optional<uint64_t> expiresAt;
+        bool mergeOperand;
+    };
+
+    std::filesystem::path path;
+    int fd = -1;
+    /*
+     * Whether fd was opened with O_DIRECT, in which case every write covers whole aligned blocks
+     */
+    bool direct = false;
+    /*
+     * Bytes already written out of the buffer
+     */
+    offset flushed = 0;
+    /*
+     * Copy of the file's first block, kept with O_DIRECT so finish can write the header without reading the
+     * block back
+     */
+    std::unique_ptr<char, decltype(&std::free)> firstBlock{nullptr, &std::free};
+    size_t index;
+    SSFileOptions options;
+    ValueLog *valueLog;
+    std::unique_ptr<char, decltype(&std::free)> buffer;
+    size_t bufferUsed = 0;
+    /*
+     * File offset of the next byte appended
+     */
+    offset position = 0;
+    std::vector<KeyChunk> chunks;
+    /*
+     * Block entries are encoded into directly when there is a single encode thread
+     */
+    EncodedBlock block;
+    std::vector<PendingEntry> pending;
+    size_t pendingBytes = 0;
+    std::string lastKey;
+    size_t entries = 0;
+    bool finished = false;
+
+    std::unique_ptr<BloomFilter> bloomFilter;
+    std::vector<uint64_t> xorKeyHashes;
+    /*
+     * Prefixes of the keys added so far, without adjacent duplicates
+     */
+    std::vector<std::string> prefixes;
+    /*
+     * Blocks being encoded by other threads, oldest first. Declared last, so it is destroyed first and any
+     * unfinished encode is waited for while the rest of the writer is still alive.
+     */
+    std::deque<std::future<EncodedBlock>> encoding;
+
+    void checkKey(const std::string &key);
+    void addEntry(const std::string &key, const DbValue *value, const ValuePointer *pointer, std::optional<uint64_t> expiresAt,
+                  bool mergeOperand = false);
+    EncodedBlock newBlock() const;
+    void encode(EncodedBlock &target, const std::string &key, const DbValue *value, const ValuePointer *pointer,
+                std::optional<uint64_t> expiresAt, bool mergeOperand) const;
+    EncodedBlock encodeAll(std::vector<PendingEntry> entries) const;
+    void dispatchPending();
+    void assembleOldest();
+    void assemble(EncodedBlock &encoded);
+    void append(const void *data, size_t length);
+    void flushBuffer();
+    void writeAt(const char *data, size_t length, offset pos);
+    void closeFile();
+    std::unique_ptr<KeyFilter> finishFilter();
+    std::unique_ptr<KeyFilter> finishPrefixFilter();
+    uint32_t appendFilter(const KeyFilter *filter);
+    void appendLearnedIndex();
+    void appendKeyChunks();
+};
+
+
+#endif
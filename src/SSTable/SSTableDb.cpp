@@ -2,27 +2,52 @@
 
 #include <utility>
 #include <algorithm>
+#include <sstream>
 #include "csv.hpp"
+#include "Expiry.h"
+#include "SSFileCursor.h"
 
 SSTableDb::SSTableDb(std::unique_ptr<DbMemCache> memCache, const std::filesystem::path& directory, bool reset, bool useBloomFilter)
-: memcache(std::move(memCache)), baseDirectory(directory), useBloomFilter(useBloomFilter){
+: SSTableDb(std::move(memCache), directory, reset, SSFileOptions{useBloomFilter ? FilterType::BLOOM : FilterType::NONE}) {}
+
+SSTableDb::SSTableDb(std::unique_ptr<DbMemCache> memCache, const std::filesystem::path& directory, bool reset, const SSFileOptions &fileOptions)
+: memcache(std::move(memCache)), baseDirectory(directory), fileOptions(fileOptions){
     if (!is_directory(directory)){
         throw std::runtime_error("Expected directory, received" + directory.string());
     }
 
+    if (fileOptions.valueLogThreshold > 0){
+        valueLog = std::make_unique<ValueLog>(baseDirectory / valueLogDirectory, reset, fileOptions.valueLogFileSize);
+    }
+
     openWriteAheadLog(reset);
     writeAheadLogWriter = std::make_unique<csv::CSVWriter<std::fstream>>(writeAheadLog);
     populateMemcacheFromLog();
     if (!reset){
+        finishFileChanges();
         populateSSTables();
     }
 }
 
 void SSTableDb::insert(const std::string &key, const DbValue& value) {
+    insertEntry(key, value, std::nullopt);
+}
+
+void SSTableDb::insert(const std::string &key, const DbValue &value, std::chrono::milliseconds ttl) {
+    insertEntry(key, value, Expiry::after(ttl));
+}
+
+void SSTableDb::insertEntry(const std::string &key, const DbValue &value, std::optional<uint64_t> expiresAt) {
     validateKey(key);
     tombstones.erase(key);
-    writeEntryToLog(key, value);
+    writeEntryToLog(key, value, expiresAt);
     memcache->insert(key, value);
+    mergeOperands.erase(key);
+    if (expiresAt.has_value()){
+        expiries[key] = expiresAt.value();
+    } else {
+        expiries.erase(key);
+    }
     if (shouldFlushMemcache()){
         flushMemcache();
     }
@@ -33,70 +58,610 @@ std::optional<DbValue> SSTableDb::get(const std::string &key) {
         return std::nullopt;
     }
 
+    // Merge operands newer than the version of the key being looked for
+    std::optional<DbValue> operand;
     auto cached = memcache->get(key);
     if (cached.has_value()){
-        return cached.value();
+        // An expired entry still shadows older versions of the key
+        if (hasExpired(key)){
+            return std::nullopt;
+        }
+        if (mergeOperands.find(key) == mergeOperands.end()){
+            return cached.value();
+        }
+        operand = std::move(cached);
     }
 
     for (auto it = ssTableFiles.rbegin(); it != ssTableFiles.rend(); it++){
         auto read = (*it)->get(key);
         switch (read.type) {
             case KEY_FOUND:
-                return read.value.value();
+                return applyOperand(readValue(read), operand);
             case KEY_TOMBSTONE:
-                return std::nullopt;
+                return operand;
+            case KEY_MERGE_OPERAND:
+                operand = applyOperand(readValue(read), operand);
+                break;
             case KEY_NOT_FOUND:
                 break;
         }
     }
 
-    return std::nullopt;
+    return operand;
+}
+
+std::vector<std::optional<DbValue>> SSTableDb::multiGet(const std::vector<std::string> &keys) {
+    std::vector<std::optional<DbValue>> results(keys.size());
+
+    // Keys that still need to be searched for in SSFiles, sorted and without duplicates
+    std::vector<std::string> pending(keys.begin(), keys.end());
+    std::sort(pending.begin(), pending.end());
+    pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+
+    std::map<std::string, std::optional<DbValue>> resolved;
+    std::vector<std::string> unresolved;
+    // Merge operands of unresolved keys, to apply once an older version of the key is found
+    std::map<std::string, DbValue> operands;
+    auto operandOf = [&operands](const std::string &key) -> std::optional<DbValue> {
+        auto operand = operands.find(key);
+        return operand == operands.end() ? std::nullopt : std::optional<DbValue>(operand->second);
+    };
+    for (auto &key : pending){
+        if (tombstones.find(key) != tombstones.end()){
+            resolved.emplace(key, std::nullopt);
+            continue;
+        }
+
+        auto cached = memcache->get(key);
+        if (cached.has_value() && (hasExpired(key) || mergeOperands.find(key) == mergeOperands.end())){
+            resolved.emplace(key, hasExpired(key) ? std::nullopt : std::move(cached));
+            continue;
+        }
+        if (cached.has_value()){
+            operands.emplace(key, std::move(cached.value()));
+        }
+
+        unresolved.push_back(std::move(key));
+    }
+
+    for (auto it = ssTableFiles.rbegin(); it != ssTableFiles.rend() && !unresolved.empty(); it++){
+        auto reads = (*it)->multiGet(unresolved);
+        std::vector<std::string> stillUnresolved;
+        for (size_t i = 0; i < unresolved.size(); i++){
+            auto &key = unresolved[i];
+            switch (reads[i].type) {
+                case KEY_FOUND:
+                    resolved.emplace(key, applyOperand(readValue(reads[i]), operandOf(key)));
+                    break;
+                case KEY_TOMBSTONE:
+                    resolved.emplace(key, operandOf(key));
+                    break;
+                case KEY_MERGE_OPERAND:
+                    operands.insert_or_assign(key, applyOperand(readValue(reads[i]), operandOf(key)));
+                    stillUnresolved.push_back(std::move(key));
+                    break;
+                case KEY_NOT_FOUND:
+                    stillUnresolved.push_back(std::move(key));
+                    break;
+            }
+        }
+        unresolved = std::move(stillUnresolved);
+    }
+    for (const auto &key : unresolved){
+        resolved.emplace(key, operandOf(key));
+    }
+
+    for (size_t i = 0; i < keys.size(); i++){
+        auto it = resolved.find(keys[i]);
+        if (it != resolved.end()){
+            results[i] = it->second;
+        }
+    }
+
+    return results;
+}
+
+std::vector<std::pair<std::string, DbValue>> SSTableDb::scanPrefix(const std::string &prefix) {
+    // Newer sources are visited first, so the first entry seen for a key shadows all later ones. Values in the
+    // value log are only read for entries that are not shadowed.
+    std::map<std::string, SSFileRead> entries;
+    for (const auto &key : tombstones){
+        if (key.compare(0, prefix.size(), prefix) == 0){
+            entries.emplace(key, SSFileRead{KEY_TOMBSTONE});
+        }
+    }
+
+    memcache->traverseSorted([&](const std::string &key, const DbValue &value){
+        if (key.compare(0, prefix.size(), prefix) == 0){
+            auto type = mergeOperands.find(key) != mergeOperands.end() ? KEY_MERGE_OPERAND : KEY_FOUND;
+            entries.emplace(key, hasExpired(key) ? SSFileRead{KEY_TOMBSTONE} : SSFileRead{type, value});
+        }
+    });
+
+    for (auto it = ssTableFiles.rbegin(); it != ssTableFiles.rend(); it++){
+        for (auto &[key, read] : (*it)->scanPrefix(prefix)){
+            auto [entry, inserted] = entries.try_emplace(std::move(key), read);
+            // A merge operand is only shadowing older versions once it has been applied to them
+            if (!inserted && entry->second.type == KEY_MERGE_OPERAND){
+                entry->second = foldMergeOperand(read, readValue(entry->second));
+            }
+        }
+    }
+
+    std::vector<std::pair<std::string, DbValue>> results;
+    for (auto &[key, read] : entries){
+        // An operand with no older version of the key is the key's value
+        if (read.type == KEY_FOUND || read.type == KEY_MERGE_OPERAND){
+            results.emplace_back(key, readValue(read));
+        }
+    }
+
+    return results;
 }
 
 void SSTableDb::remove(const std::string &key) {
     writeTombstoneToLog(key);
     tombstones.insert(key);
     memcache->remove(key);
+    expiries.erase(key);
+    mergeOperands.erase(key);
+}
+
+void SSTableDb::merge(const std::string &key, const DbValue &operand) {
+    validateKey(key);
+    if (!fileOptions.mergeOperator){
+        throw std::runtime_error("Merging requires fileOptions.mergeOperator to be set");
+    }
+
+    // An expired entry hides every older version of the key, so the operand becomes its value. It is logged as an
+    // insert: replaying the log runs after the entry expired, whether or not it had when the operand was merged.
+    if (hasExpired(key)){
+        insertEntry(key, operand, std::nullopt);
+        return;
+    }
+
+    // Applying the operand throws for operands the operator can't combine, so it happens before logging them
+    applyMerge(key, operand);
+    writeMergeToLog(key, operand);
+    if (shouldFlushMemcache()){
+        flushMemcache();
+    }
+}
+
+void SSTableDb::applyMerge(const std::string &key, const DbValue &operand) {
+    // A tombstone hides every older version of the key, so the operand becomes its value. Expiry isn't checked:
+    // merge already turned operands on expired entries into inserts, and when the log is replayed, an entry may
+    // have expired since the operand was applied to it, in which case the result keeps the entry's expiry.
+    auto hidesOlder = tombstones.find(key) != tombstones.end();
+    auto cached = hidesOlder ? std::nullopt : memcache->get(key);
+    memcache->insert(key, cached.has_value() ? mergeOperator().merge(cached.value(), operand) : operand);
+    if (hidesOlder){
+        tombstones.erase(key);
+    } else if (!cached.has_value()){
+        mergeOperands.insert(key);
+    }
+}
+
+const MergeOperator &SSTableDb::mergeOperator() const {
+    if (!fileOptions.mergeOperator){
+        throw std::runtime_error("The database holds merge operands, but fileOptions.mergeOperator is not set");
+    }
+    return *fileOptions.mergeOperator;
+}
+
+DbValue SSTableDb::applyOperand(const DbValue &older, const std::optional<DbValue> &operand) const {
+    return operand.has_value() ? mergeOperator().merge(older, operand.value()) : older;
+}
+
+SSFileRead SSTableDb::foldMergeOperand(const SSFileRead &older, const DbValue &operand) {
+    switch (older.type) {
+        case KEY_FOUND:
+            return {KEY_FOUND, mergeOperator().merge(readValue(older), operand), std::nullopt, older.expiresAt};
+        case KEY_MERGE_OPERAND:
+            return {KEY_MERGE_OPERAND, mergeOperator().merge(readValue(older), operand)};
+        case KEY_TOMBSTONE:
+        case KEY_NOT_FOUND:
+            break;
+    }
+    return {KEY_FOUND, operand};
+}
+
+bool SSTableDb::hasExpired(const std::string &key) const {
+    auto expiry = expiries.find(key);
+    return expiry != expiries.end() && Expiry::hasPassed(expiry->second);
 }
 
 void SSTableDb::flushMemcache() {
-    if (memcache->size() == 0){
+    if (memcache->size() == 0 && tombstones.empty()){
         return;
     }
 
-    auto newIndex = ssTableFiles.size();
-    uint32_t filterBits = useBloomFilter ? SSTable::bloomFilterBits : 0;
-    auto file = SSFileCreator::newFile(baseDirectory / ssTablesDirectory, newIndex, filterBits, memcache.get(), tombstones);
+    auto file = SSFileCreator::newFile(baseDirectory / ssTablesDirectory, nextFileIndex, fileOptions, memcache.get(), tombstones, valueLog.get(), expiries, mergeOperands);
     ssTableFiles.push_back(std::move(file));
+    nextFileIndex++;
     memcache->clear();
+    expiries.clear();
+    mergeOperands.clear();
+    // The flushed file holds the tombstones now, and a newer ingested file must be able to shadow them
+    tombstones.clear();
     clearWriteAheadLog();
 }
 
+size_t SSTableDb::ingestSortedCsv(const std::filesystem::path &csvFile) {
+    flushMemcache();
+
+    auto directory = baseDirectory / ssTablesDirectory;
+    std::vector<std::unique_ptr<SSFile>> files;
+    std::vector<std::pair<std::filesystem::path, std::filesystem::path>> renames;
+    std::unique_ptr<SSFileWriter> writer;
+    size_t ingested = 0;
+
+    auto add = [&](const std::string &key, const DbValue &value){
+        if (!writer){
+            auto index = nextFileIndex + files.size();
+            auto finalName = SSFileCreator::filename(index);
+            renames.emplace_back(finalName.string() + stagedExtension, finalName);
+            writer = std::make_unique<SSFileWriter>(directory / renames.back().first, index, fileOptions, valueLog.get());
+        }
+
+        writer->add(key, value);
+        ingested++;
+        if (writer->fileSize() >= SSTable::ingestFileSize){
+            files.push_back(writer->finish());
+            writer.reset();
+        }
+    };
+
+    try {
+        csv::CSVFormat format;
+        format.column_names({"key", "value_type", "value"});
+        csv::CSVReader reader(csvFile.string(), format);
+
+        // A row is only added once the next key is known to differ, so the last row for a key wins
+        std::optional<std::pair<std::string, DbValue>> pending;
+        for (csv::CSVRow &row : reader){
+            auto key = row[0].get<std::string>();
+            validateKey(key);
+            if (pending.has_value() && key != pending->first){
+                if (key < pending->first){
+                    throw std::runtime_error("CSV file " + csvFile.string() + " is not sorted, " + key + " comes after " + pending->first);
+                }
+                add(pending->first, pending->second);
+            }
+
+            pending.emplace(std::move(key), dbValueFromString(row[1].get<int>(), row[2].get<std::string>()));
+        }
+
+        if (pending.has_value()){
+            add(pending->first, pending->second);
+        }
+        if (writer){
+            files.push_back(writer->finish());
+            writer.reset();
+        }
+    } catch (...) {
+        writer.reset();
+        files.clear();
+        for (const auto &[staged, finalName] : renames){
+            std::filesystem::remove(directory / staged);
+        }
+        throw;
+    }
+
+    if (files.empty()){
+        return 0;
+    }
+
+    commitFileChanges({}, renames);
+
+    // The files were opened before being renamed, which doesn't affect reading them
+    nextFileIndex += files.size();
+    for (auto &file : files){
+        ssTableFiles.push_back(std::move(file));
+    }
+    return ingested;
+}
+
+void SSTableDb::compact() {
+    if (ssTableFiles.empty()){
+        return;
+    }
+
+    auto directory = baseDirectory / ssTablesDirectory;
+    std::vector<std::unique_ptr<SSFile>> files;
+    std::vector<std::pair<std::filesystem::path, std::filesystem::path>> renames;
+    std::unique_ptr<SSFileWriter> writer;
+
+    // Files are only started once they have an entry, so dropping every entry leaves no file to add
+    auto output = [&]() -> SSFileWriter& {
+        if (!writer){
+            auto index = nextFileIndex + files.size();
+            auto finalName = SSFileCreator::filename(index);
+            renames.emplace_back(finalName.string() + stagedExtension, finalName);
+            writer = std::make_unique<SSFileWriter>(directory / renames.back().first, index, fileOptions, valueLog.get());
+        }
+        return *writer;
+    };
+
+    try {
+        // Newest file first, so the first cursor positioned on a key holds its live version
+        std::vector<std::unique_ptr<SSFileCursor>> cursors;
+        for (auto it = ssTableFiles.rbegin(); it != ssTableFiles.rend(); it++){
+            cursors.push_back((*it)->newCursor());
+        }
+
+        while (true){
+            std::optional<size_t> newest;
+            for (size_t i = 0; i < cursors.size(); i++){
+                if (cursors[i]->valid() && (!newest.has_value() || cursors[i]->key() < cursors[newest.value()]->key())){
+                    newest = i;
+                }
+            }
+            if (!newest.has_value()){
+                break;
+            }
+
+            // Merge operands are applied to the older versions of the key, down to the oldest file if need be
+            auto key = cursors[newest.value()]->key();
+            SSFileRead read{KEY_NOT_FOUND};
+            for (auto &cursor : cursors){
+                if (!cursor->valid() || cursor->key() != key){
+                    continue;
+                }
+                if (read.type == KEY_MERGE_OPERAND){
+                    read = foldMergeOperand(cursor->read(), readValue(read));
+                } else if (read.type == KEY_NOT_FOUND){
+                    read = cursor->read();
+                }
+                cursor->next();
+            }
+
+            // Expired entries read as tombstones, and with no older file left neither needs to be kept. Nothing
+            // older is left for an operand to apply to either, so it becomes the value.
+            if (read.type == KEY_FOUND || read.type == KEY_MERGE_OPERAND){
+                auto decision = CompactionFilter::Decision::KEEP;
+                DbValue rewritten;
+                if (fileOptions.compactionFilter){
+                    decision = fileOptions.compactionFilter->filter(key, readValue(read), rewritten);
+                }
+
+                if (decision == CompactionFilter::Decision::DROP){
+                    continue;
+                }
+                if (decision == CompactionFilter::Decision::REWRITE){
+                    output().add(key, rewritten, read.expiresAt);
+                } else if (read.valuePointer.has_value()){
+                    output().addValuePointer(key, read.valuePointer.value(), read.expiresAt);
+                } else {
+                    output().add(key, read.value.value(), read.expiresAt);
+                }
+                if (writer->fileSize() >= SSTable::compactionFileSize){
+                    files.push_back(writer->finish());
+                    writer.reset();
+                }
+            }
+        }
+
+        if (writer){
+            files.push_back(writer->finish());
+            writer.reset();
+        }
+    } catch (...) {
+        writer.reset();
+        files.clear();
+        for (const auto &[staged, finalName] : renames){
+            std::filesystem::remove(directory / staged);
+        }
+        throw;
+    }
+
+    std::vector<std::filesystem::path> removed;
+    for (const auto &file : ssTableFiles){
+        removed.push_back(SSFileCreator::filename(file->getIndex()));
+    }
+    commitFileChanges(removed, renames);
+
+    ssTableFiles = std::move(files);
+    nextFileIndex += ssTableFiles.size();
+}
+
+void SSTableDb::createCheckpoint(const std::filesystem::path &directory) {
+    if (std::filesystem::exists(directory)){
+        throw std::runtime_error("Checkpoint directory " + directory.string() + " already exists");
+    }
+    std::filesystem::create_directories(directory / ssTablesDirectory);
+
+    auto linkOrCopy = [&](const std::filesystem::path &file){
+        std::error_code error;
+        std::filesystem::create_hard_link(baseDirectory / file, directory / file, error);
+        if (error){
+            std::filesystem::copy_file(baseDirectory / file, directory / file);
+        }
+    };
+
+    // Paths relative to the database directory
+    std::vector<std::filesystem::path> files;
+    writeAheadLog.flush();
+    std::filesystem::copy_file(baseDirectory / writeAheadLogFilename, directory / writeAheadLogFilename);
+    files.push_back(writeAheadLogFilename);
+    for (const auto &file : ssTableFiles){
+        files.push_back(ssTablesDirectory / SSFileCreator::filename(file->getIndex()));
+        linkOrCopy(files.back());
+    }
+
+    if (valueLog){
+        valueLog->sync();
+        std::filesystem::create_directories(directory / valueLogDirectory);
+        for (auto fileNumber : valueLog->getFileNumbers()){
+            files.push_back(valueLogDirectory / valueLog->filePath(fileNumber).filename());
+            if (fileNumber == valueLog->headFileNumber()){
+                std::filesystem::copy_file(baseDirectory / files.back(), directory / files.back());
+            } else {
+                linkOrCopy(files.back());
+            }
+        }
+    }
+
+    auto manifestPath = directory / checkpointManifestFilename;
+    auto stagedManifestPath = manifestPath;
+    stagedManifestPath += stagedExtension;
+    {
+        std::ofstream manifest(stagedManifestPath, std::ios::trunc);
+        manifest.exceptions(std::ios::badbit | std::ios::failbit);
+        for (const auto &file : files){
+            manifest << file.string() << ' ' << std::filesystem::file_size(directory / file) << '\n';
+        }
+    }
+    std::filesystem::rename(stagedManifestPath, manifestPath);
+}
+
+void SSTableDb::commitFileChanges(const std::vector<std::filesystem::path> &removed,
+                                  const std::vector<std::pair<std::filesystem::path, std::filesystem::path>> &renames) {
+    // The manifest is the commit point. It is written under a temporary name and renamed into place, so it is
+    // either complete or absent, and once it exists every change listed in it will be made, even after a crash.
+    auto manifestPath = baseDirectory / fileChangesManifestFilename;
+    auto stagedManifestPath = manifestPath;
+    stagedManifestPath += stagedExtension;
+    {
+        std::ofstream manifest(stagedManifestPath, std::ios::trunc);
+        manifest.exceptions(std::ios::badbit | std::ios::failbit);
+        for (const auto &file : removed){
+            manifest << "remove " << file.string() << '\n';
+        }
+        for (const auto &[staged, finalName] : renames){
+            manifest << "rename " << staged.string() << ' ' << finalName.string() << '\n';
+        }
+    }
+    std::filesystem::rename(stagedManifestPath, manifestPath);
+    finishFileChanges();
+}
+
+bool SSTableDb::collectValueLogGarbage() {
+    // The head of the log is still being appended to
+    if (!valueLog || valueLog->numFiles() < 2){
+        return false;
+    }
+
+    auto fileNumber = valueLog->oldestFileNumber();
+    for (const auto &record : valueLog->readRecords(fileNumber)){
+        std::optional<uint64_t> expiresAt;
+        if (isValueLogRecordLive(record, expiresAt)){
+            // get also applies merge operands written after the record
+            insertEntry(record.key, get(record.key).value(), expiresAt);
+        }
+    }
+
+    // Older SSFiles may still point into the file, but those entries are now shadowed by the flushed ones
+    flushMemcache();
+    valueLog->removeFile(fileNumber);
+    return true;
+}
+
+bool SSTableDb::isValueLogRecordLive(const ValueLog::Record &record, std::optional<uint64_t> &expiresAt) {
+    if (tombstones.find(record.key) != tombstones.end()){
+        return false;
+    }
+    // A merge operand in the memcache still needs the value it applies to
+    if (memcache->get(record.key).has_value() && mergeOperands.find(record.key) == mergeOperands.end()){
+        return false;
+    }
+
+    for (auto it = ssTableFiles.rbegin(); it != ssTableFiles.rend(); it++){
+        auto read = (*it)->get(record.key);
+        switch (read.type) {
+            case KEY_FOUND:
+                expiresAt = read.expiresAt;
+                return read.valuePointer.has_value() && read.valuePointer.value() == record.pointer;
+            case KEY_TOMBSTONE:
+                return false;
+            case KEY_MERGE_OPERAND:
+            case KEY_NOT_FOUND:
+                break;
+        }
+    }
+
+    return false;
+}
+
+DbValue SSTableDb::readValue(const SSFileRead &read) {
+    if (!read.valuePointer.has_value()){
+        return read.value.value();
+    }
+
+    if (!valueLog){
+        throw std::runtime_error("SSFile points to a value log, but the value log is disabled. Set fileOptions.valueLogThreshold.");
+    }
+    return valueLog->read(read.valuePointer.value());
+}
+
 SSTableDb::~SSTableDb() {
     flushMemcache();
 }
 
 bool SSTableDb::shouldFlushMemcache() {
+    if (fileOptions.memcacheFlushBytes > 0){
+        return memcache->memoryUsage() >= fileOptions.memcacheFlushBytes;
+    }
+
     return memcache->size() >= SSTable::maxMemcacheSize;
 }
 
+void SSTableDb::finishFileChanges() {
+    auto directory = baseDirectory / ssTablesDirectory;
+    auto manifestPath = baseDirectory / fileChangesManifestFilename;
+    if (std::filesystem::exists(manifestPath)){
+        std::ifstream manifest(manifestPath);
+        std::string line;
+        while (std::getline(manifest, line)){
+            std::istringstream change(line);
+            std::string operation, name, finalName;
+            change >> operation >> name;
+            // Changes made before a crash are found already done, and skipped
+            if (operation == "remove"){
+                std::filesystem::remove(directory / name);
+            } else if (operation == "rename" && change >> finalName && std::filesystem::exists(directory / name)){
+                std::filesystem::rename(directory / name, directory / finalName);
+            }
+        }
+        manifest.close();
+        std::filesystem::remove(manifestPath);
+    }
+
+    // Leftovers from an ingest or compaction that failed or crashed before writing its manifest
+    auto stagedManifestPath = manifestPath;
+    stagedManifestPath += stagedExtension;
+    std::filesystem::remove(stagedManifestPath);
+    std::vector<std::filesystem::path> leftovers;
+    for (const auto& dirEntry : std::filesystem::directory_iterator(directory)){
+        if (dirEntry.is_regular_file() && dirEntry.path().extension() == stagedExtension){
+            leftovers.push_back(dirEntry.path());
+        }
+    }
+    for (const auto &path : leftovers){
+        std::filesystem::remove(path);
+    }
+}
+
 void SSTableDb::populateSSTables() {
     for (const auto& dirEntry : std::filesystem::directory_iterator(baseDirectory / ssTablesDirectory)){
         if (dirEntry.is_regular_file() && SSFileCreator::isFilenameSSTable(dirEntry.path().filename())){
-            ssTableFiles.push_back(SSFileCreator::loadFile(dirEntry.path()));
+            ssTableFiles.push_back(SSFileCreator::loadFile(dirEntry.path(), fileOptions));
         }
     }
 
     std::sort(ssTableFiles.begin(), ssTableFiles.end(), [] (const std::unique_ptr<SSFile>& lhs, const std::unique_ptr<SSFile> &rhs){
         return lhs->getIndex() < rhs->getIndex();
     });
+    nextFileIndex = ssTableFiles.empty() ? 0 : ssTableFiles.back()->getIndex() + 1;
 }
 
 void SSTableDb::populateMemcacheFromLog() {
     writeAheadLog.seekg(0);
-    std::vector<std::string> col_names = {"tombstone", "key", "value_type", "value"};
+    std::vector<std::string> col_names = {"tombstone", "key", "value_type", "value", "expires_at"};
     csv::CSVFormat format;
     format.column_names(col_names);
+    // Logs written before entries could expire have no expires_at column
+    format.variable_columns(csv::VariableColumnPolicy::KEEP);
     csv::CSVReader reader(writeAheadLog, format);
     for (csv::CSVRow &row : reader){
         processWriteAheadLogLine(row);
@@ -108,26 +673,49 @@ void SSTableDb::populateMemcacheFromLog() {
 
 void SSTableDb::processWriteAheadLogLine(csv::CSVRow &row) {
     auto key = row["key"].get<std::string>();
-    if (row["tombstone"].get<int>()){
+    // 1 for a remove and 2 for a merge
+    auto kind = row["tombstone"].get<int>();
+    if (kind == 1){
         tombstones.insert(key);
         memcache->remove(key);
+        expiries.erase(key);
+        mergeOperands.erase(key);
         return;
     }
 
     tombstones.erase(key);
     auto valueTypeIndex = row["value_type"].get<int>();
     auto valueStr = row["value"].get<std::string>();
+    if (kind == 2){
+        applyMerge(key, dbValueFromString(valueTypeIndex, valueStr));
+        return;
+    }
+
+    mergeOperands.erase(key);
     memcache->insert(key, dbValueFromString(valueTypeIndex, valueStr));
+    // 0 when the entry doesn't expire. Expired entries are kept, so they go on shadowing older versions of the key.
+    auto expiresAt = row.size() > 4 ? row["expires_at"].get<uint64_t>() : 0;
+    if (expiresAt > 0){
+        expiries[key] = expiresAt;
+    } else {
+        expiries.erase(key);
+    }
+}
+
+void SSTableDb::writeEntryToLog(const std::string &key, const DbValue &value, std::optional<uint64_t> expiresAt) {
+    writeAheadLog.seekg(0, std::ios::end);
+    *writeAheadLogWriter << std::vector<std::string>({"0", key, std::to_string(value.index()), dbValueToString(value),
+                                                      std::to_string(expiresAt.value_or(0))});
 }
 
-void SSTableDb::writeEntryToLog(const std::string &key, const DbValue &value) {
+void SSTableDb::writeMergeToLog(const std::string &key, const DbValue &operand) {
     writeAheadLog.seekg(0, std::ios::end);
-    *writeAheadLogWriter << std::vector<std::string>({"0", key, std::to_string(value.index()), dbValueToString(value)});
+    *writeAheadLogWriter << std::vector<std::string>({"2", key, std::to_string(operand.index()), dbValueToString(operand), "0"});
 }
 
 void SSTableDb::writeTombstoneToLog(const std::string &key) {
     writeAheadLog.seekg(0, std::ios::end);
-    *writeAheadLogWriter << std::vector<std::string>({"1", key, "0", "0"});
+    *writeAheadLogWriter << std::vector<std::string>({"1", key, "0", "0", "0"});
 }
 
 void SSTableDb::openWriteAheadLog(bool reset) {
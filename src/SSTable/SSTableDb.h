@@ -1,7 +1,10 @@
 #ifndef DATAINTENSIVE_SSTABLEDB_H
 #define DATAINTENSIVE_SSTABLEDB_H
 
+#include <chrono>
 #include <fstream>
+#include <unordered_map>
+#include <unordered_set>
 #include "../KeyValueDb.h"
 #include "../DatabaseEntry.h"
 #include "MemCache.h"
@@ -12,32 +15,140 @@
 class SSTableDb : public KeyValueDb<std::string, DbValue> {
 public:
     explicit SSTableDb(std::unique_ptr<DbMemCache> memCache, const std::filesystem::path& directory = ".", bool reset=false, bool useBloomFilter=false);
+    SSTableDb(std::unique_ptr<DbMemCache> memCache, const std::filesystem::path& directory, bool reset, const SSFileOptions &fileOptions);
     void insert(const std::string &key, const DbValue& value) override;
+    /*
+     * Inserts an entry that expires ttl from now. Once expired, the entry reads as removed, a flush writes it as a
+     * tombstone and compact() drops it. Inserting or removing the key again replaces the TTL.
+     */
+    void insert(const std::string &key, const DbValue& value, std::chrono::milliseconds ttl);
     std::optional<DbValue> get(const std::string &key) override;
     void remove(const std::string &key) override;
+    /*
+     * Applies operand to the key's value with fileOptions.mergeOperator, without reading the value. When the key
+     * isn't in the memcache, the operand is stored as a merge record, and it is applied when the key is read or
+     * compacted. Consecutive operands are folded together in the memcache, so repeated merges to the same key only
+     * ever keep one record per file. A value with a TTL keeps its expiry when operands are applied to it in the
+     * memcache, and an operand merged into an expired or removed key becomes a value without one. Merge records
+     * carry no expiry, so once the SSFile value they apply to expires, they read as the key's value.
+     */
+    void merge(const std::string &key, const DbValue &operand);
+    /*
+     * Equivalent to calling get for every key, with results[i] corresponding to keys[i]. The keys are sorted
+     * once, the memcache is checked once, and then every SSFile is probed for all keys that are still unresolved.
+     */
+    std::vector<std::optional<DbValue>> multiGet(const std::vector<std::string> &keys);
+    /*
+     * Returns every live entry whose key starts with prefix, sorted by key. Files whose prefix filter rules out
+     * the prefix are not read.
+     */
+    std::vector<std::pair<std::string, DbValue>> scanPrefix(const std::string &prefix);
+    /*
+     * Reclaims the oldest value log file. Values in it that are still live are inserted again, which moves them
+     * to the head of the log on the next flush, and the file is deleted once the memcache has been flushed.
+     * Returns false if there was nothing to collect. The value log is only used when fileOptions.valueLogThreshold
+     * is set.
+     */
+    bool collectValueLogGarbage();
+    /*
+     * Builds SSFiles straight from a CSV file sorted by key, without going through the write ahead log or the
+     * memcache. Rows have no header and hold "key,value_type,value", the write ahead log's columns without the
+     * tombstone flag and the expiry. Ingested entries never expire. When a key repeats, its last row wins. A new file is started every SSTable::ingestFileSize
+     * bytes.
+     *
+     * The memcache is flushed first, so ingested entries shadow everything already in the database. Files are
+     * built under temporary names and added together: if the input is unsorted or any file fails to build, none
+     * of them is added, and if the process dies while they are being renamed, the next open finishes the renames.
+     * Returns the number of entries ingested.
+     */
+    size_t ingestSortedCsv(const std::filesystem::path &csvFile);
+    /*
+     * Merges every SSFile into new ones of about SSTable::compactionFileSize bytes each, keeping only the newest
+     * version of each key and dropping tombstones and expired entries, since no older file is left for them to
+     * shadow, as well as entries the fileOptions.compactionFilter drops. Values in the value log are not copied,
+     * the new files point at them, unless the filter rewrites them. The new files replace the old ones the same
+     * way ingested files are added, so a crash either keeps the old files or finishes the replacement on the next
+     * open.
+     */
+    void compact();
+    /*
+     * Creates a copy of the database in directory, which must not exist yet, that can be opened as a database of
+     * its own. SSFiles are never modified once written, so they are hard linked instead of copied, and so are
+     * value log files other than the head, which is still appended to. The write ahead log is copied, so the
+     * memcache doesn't have to be flushed. A manifest listing every file is written last, so a checkpoint without
+     * one is incomplete. Files are copied when directory is on another file system, where hard links can't point.
+     */
+    void createCheckpoint(const std::filesystem::path &directory);
     ~SSTableDb() override;
 
 private:
     std::filesystem::path baseDirectory;
     std::unique_ptr<DbMemCache> memcache;
     std::set<std::string> tombstones;
-    bool useBloomFilter;
+    /*
+     * Expiry time of every memcache entry inserted with a TTL
+     */
+    std::unordered_map<std::string, uint64_t> expiries;
+    /*
+     * Memcache keys whose value is a merge operand still to be applied to the value in the SSFiles
+     */
+    std::unordered_set<std::string> mergeOperands;
+    SSFileOptions fileOptions;
     const std::filesystem::path writeAheadLogFilename = "write_ahead_log.csv";
     const std::filesystem::path ssTablesDirectory = "sstables";
+    const std::filesystem::path valueLogDirectory = "vlog";
+    const std::filesystem::path fileChangesManifestFilename = "file_changes";
+    const std::string stagedExtension = ".staged";
+    const std::filesystem::path checkpointManifestFilename = "checkpoint_manifest";
     std::fstream writeAheadLog;
     std::unique_ptr<csv::CSVWriter<std::fstream>> writeAheadLogWriter;
     std::vector<std::unique_ptr<SSFile>> ssTableFiles;
+    /*
+     * One past the index of the newest SSFile. Compactions leave gaps in the indexes, so this can be larger than
+     * the number of files.
+     */
+    size_t nextFileIndex = 0;
+    std::unique_ptr<ValueLog> valueLog;
 
 
     bool shouldFlushMemcache();
     void flushMemcache();
     void populateMemcacheFromLog();
     void populateSSTables();
-    void writeEntryToLog(const std::string &key, const DbValue &value);
+    void insertEntry(const std::string &key, const DbValue &value, std::optional<uint64_t> expiresAt);
+    bool hasExpired(const std::string &key) const;
+    void applyMerge(const std::string &key, const DbValue &operand);
+    const MergeOperator& mergeOperator() const;
+    /*
+     * older with operand applied on top of it, if there is an operand
+     */
+    DbValue applyOperand(const DbValue &older, const std::optional<DbValue> &operand) const;
+    /*
+     * Read of older with a newer merge operand applied on top of it
+     */
+    SSFileRead foldMergeOperand(const SSFileRead &older, const DbValue &operand);
+    /*
+     * Atomically deletes the removed SSFiles and renames the staged ones (both relative to the SSFile directory),
+     * by writing the file changes manifest and then applying it
+     */
+    void commitFileChanges(const std::vector<std::filesystem::path> &removed,
+                           const std::vector<std::pair<std::filesystem::path, std::filesystem::path>> &renames);
+    /*
+     * Applies the file changes manifest, if there is one, and deletes staged files that never made it into a
+     * manifest
+     */
+    void finishFileChanges();
+    void writeEntryToLog(const std::string &key, const DbValue &value, std::optional<uint64_t> expiresAt);
     void writeTombstoneToLog(const std::string &key);
+    void writeMergeToLog(const std::string &key, const DbValue &operand);
     void clearWriteAheadLog();
     void openWriteAheadLog(bool reset=false);
     void processWriteAheadLogLine(csv::CSVRow &row);
+    DbValue readValue(const SSFileRead &read);
+    /*
+     * Sets expiresAt to the expiry time of the live entry, if it has one
+     */
+    bool isValueLogRecordLive(const ValueLog::Record &record, std::optional<uint64_t> &expiresAt);
     static void validateKey(const std::string &key);
 };
 
@@ -1,6 +1,9 @@
 #ifndef DATAINTENSIVE_SSTABLEPARAMS_H
 #define DATAINTENSIVE_SSTABLEPARAMS_H
 
+#include <cstddef>
+#include <cstdint>
+
 namespace SSTable {
     constexpr int maxKeySize = 1024;
     constexpr int maxMemcacheSize = 4096;
@@ -11,6 +14,80 @@ namespace SSTable {
  */
     constexpr int bloomFilterBits = 20'000;
     constexpr int bloomFilterHashes = 3;
+
+/*
+ * Every SSFile header starts with ssFileMagic and the format version it was written with. Files with a different
+ * version are rejected rather than misread, so ssFileFormatVersion must change whenever the layout does.
+ */
+    constexpr uint32_t ssFileMagic = 0x53534631; // "SSF1"
+    constexpr uint32_t ssFileFormatVersion = 2;
+
+/*
+ * Maximum distance between a key's position in its KeyChunk and the position predicted by the learned index.
+ * Lookups binary search a window of twice this size.
+ */
+    constexpr int learnedIndexMaxError = 8;
+
+/*
+ * The value log starts a new file once the current one reaches this size. Garbage collection reclaims one file
+ * at a time, so this also bounds the work done by each collection.
+ */
+    constexpr uint64_t maxValueLogFileSize = 4 * 1024 * 1024;
+
+/*
+ * Size of the blocks memcaches allocate their nodes from
+ */
+    constexpr size_t arenaBlockSize = 64 * 1024;
+
+/*
+ * SSFiles are written through a buffer of this size, aligned to writeBufferAlignment, so the file is built with a
+ * few large writes instead of one per value and key. writeBufferAlignment is also the block size O_DIRECT writes
+ * are padded to.
+ */
+    constexpr size_t writeBufferSize = 1024 * 1024;
+    constexpr size_t writeBufferAlignment = 4096;
+    static_assert(writeBufferSize % writeBufferAlignment == 0, "O_DIRECT writes of a full buffer must be aligned");
+
+/*
+ * A parallel sort only uses as many threads as it can give at least this many entries each
+ */
+    constexpr size_t parallelSortMinRun = 16 * 1024;
+
+/*
+ * SSFileWriter encodes entries in blocks of about this many bytes of keys and values. With several encode threads
+ * each block is a task, so blocks must be large enough to outweigh handing them to another thread.
+ */
+    constexpr size_t encodeBlockSize = 256 * 1024;
+
+/*
+ * Threads in the pool that serves batched reads with pread, shared by every SSFile. Threads mostly wait on the
+ * disk, so there can be more of them than cores.
+ */
+    constexpr size_t readThreads = 16;
+
+/*
+ * Most reads each thread's io_uring keeps in flight
+ */
+    constexpr unsigned int ioUringQueueDepth = 64;
+
+/*
+ * Sequential readers start with reads of readaheadMinSize bytes, and double the size of every read that continues
+ * where the previous one ended, up to readaheadMaxSize
+ */
+    constexpr size_t readaheadMinSize = 4 * 1024;
+    constexpr size_t readaheadMaxSize = 2 * 1024 * 1024;
+
+/*
+ * Ingesting a CSV file starts a new SSFile once the current one holds this many bytes of values. Key chunks stay
+ * in memory until a file is finished, so this also bounds the memory an ingest uses.
+ */
+    constexpr uint64_t ingestFileSize = 64 * 1024 * 1024;
+
+/*
+ * A compaction starts a new SSFile once the current one holds this many bytes. SSFile headers store 32 bit
+ * offsets, so no single file may reach 4 GiB.
+ */
+    constexpr uint64_t compactionFileSize = 64 * 1024 * 1024;
 }
 
 
@@ -0,0 +1,45 @@
+#include "SequentialReader.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include "AsyncReader.h"
+#include "SSTableParams.h"
+
+SequentialReader::SequentialReader(int fd, uint64_t end, bool adaptiveReadahead) : fd(fd), end(end),
+                                   adaptiveReadahead(adaptiveReadahead), nextWindowSize(SSTable::readaheadMinSize) {}
+
+void SequentialReader::read(uint64_t pos, size_t length, char *out) {
+    if (pos >= windowStart && pos + length <= windowEnd()){
+        std::memcpy(out, window.data() + (pos - windowStart), length);
+        return;
+    }
+
+    // Small gaps, such as skipping a value, still continue the scan
+    bool continuesWindow = window.empty() || (pos >= windowStart && pos <= windowEnd() + window.size());
+    if (!continuesWindow){
+        AsyncReader::readFully(fd, {pos, length, out});
+        return;
+    }
+
+    fill(pos, length);
+    std::memcpy(out, window.data(), length);
+}
+
+uint64_t SequentialReader::windowEnd() const {
+    return windowStart + window.size();
+}
+
+void SequentialReader::fill(uint64_t pos, size_t length) {
+    auto size = std::max<uint64_t>(length, std::min<uint64_t>(nextWindowSize, end - std::min(end, pos)));
+    window.resize(size);
+    windowStart = pos;
+    AsyncReader::readFully(fd, {pos, size, window.data()});
+
+    if (adaptiveReadahead){
+        nextWindowSize = std::min(2 * nextWindowSize, SSTable::readaheadMaxSize);
+        // The kernel reads the next window in the background while this one is consumed
+        if (windowEnd() < end){
+            posix_fadvise(fd, static_cast<off_t>(windowEnd()), static_cast<off_t>(std::min<uint64_t>(nextWindowSize, end - windowEnd())), POSIX_FADV_WILLNEED);
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef DATAINTENSIVE_SEQUENTIALREADER_H
+#define DATAINTENSIVE_SEQUENTIALREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Reads a range of a file that is mostly consumed front to back, such as the values or a key chunk of an SSFile
+ * being scanned. Reads are served from a buffer holding a window of the file. With adaptive readahead, every
+ * time a read continues past the window, the next window is twice as large (up to SSTable::readaheadMaxSize),
+ * and the kernel is asked to prefetch the window after it, so a long scan ends up issuing a few large reads
+ * while the disk is already fetching the next one. Reads outside the window that don't continue it are served
+ * with a single pread, and leave the window as it is.
+ *
+ * The file descriptor is not owned, and is only used with pread, so readers can share it.
+ */
+class SequentialReader {
+public:
+    /*
+     * Reads never go past end
+     */
+    SequentialReader(int fd, uint64_t end, bool adaptiveReadahead);
+    void read(uint64_t pos, size_t length, char *out);
+
+private:
+    int fd;
+    uint64_t end;
+    bool adaptiveReadahead;
+    std::vector<char> window;
+    uint64_t windowStart = 0;
+    size_t nextWindowSize;
+
+    uint64_t windowEnd() const;
+    void fill(uint64_t pos, size_t length);
+};
+
+
+#endif
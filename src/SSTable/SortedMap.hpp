@@ -14,16 +14,37 @@ public:
     void insert(const K& k, const V& v) override;
     bool remove(const K& key) override;
     void traverseSorted(const std::function<void(const K& k, const V& v)>& callback) const override;
+    std::unique_ptr<typename MemCache<K, V>::Cursor> newCursor() const override;
     [[nodiscard]] size_t size() const override;
+    size_t memoryUsage() const override;
     void clear() override;
 
 private:
+    class SortedCursor : public MemCache<K, V>::Cursor {
+    public:
+        explicit SortedCursor(const std::map<K, V> &map) : it(map.begin()), end(map.end()) {};
+        bool valid() const override { return it != end; }
+        void next() override { ++it; }
+        const K& key() const override { return it->first; }
+        const V& value() const override { return it->second; }
+
+    private:
+        typename std::map<K, V>::const_iterator it, end;
+    };
+
+    /*
+     * A red-black tree node holds the entry, its color and three pointers
+     */
+    static constexpr size_t nodeSize = sizeof(typename std::map<K, V>::value_type) + 4 * sizeof(void*);
+
     std::map<K, V> map;
+    size_t bytes = 0;
 };
 
 template<class K, class V>
 void SortedMap<K, V>::clear() {
     map.clear();
+    bytes = 0;
 }
 
 template<class K, class V>
@@ -31,6 +52,11 @@ size_t SortedMap<K, V>::size() const {
     return map.size();
 }
 
+template<class K, class V>
+size_t SortedMap<K, V>::memoryUsage() const {
+    return bytes;
+}
+
 template<class K, class V>
 void SortedMap<K, V>::traverseSorted(const std::function<void(const K &, const V &)> &callback) const {
     for (const auto &pair: map){
@@ -38,14 +64,28 @@ void SortedMap<K, V>::traverseSorted(const std::function<void(const K &, const V
     }
 }
 
+template<class K, class V>
+std::unique_ptr<typename MemCache<K, V>::Cursor> SortedMap<K, V>::newCursor() const {
+    return std::make_unique<SortedCursor>(map);
+}
+
 template<class K, class V>
 bool SortedMap<K, V>::remove(const K &key) {
-    return map.erase(key) > 1;
+    auto it = map.find(key);
+    if (it == map.end()){
+        return false;
+    }
+
+    bytes -= nodeSize + approximateHeapSize(it->first) + approximateHeapSize(it->second);
+    map.erase(it);
+    return true;
 }
 
 template<class K, class V>
 void SortedMap<K, V>::insert(const K &k, const V &v) {
-    map.insert({k, v});
+    if (map.insert({k, v}).second){
+        bytes += nodeSize + approximateHeapSize(k) + approximateHeapSize(v);
+    }
 }
 
 template<class K, class V>
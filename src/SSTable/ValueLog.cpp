@@ -0,0 +1,188 @@
+#include "ValueLog.h"
+#include <stdexcept>
+#include <utility>
+#include "fmt/format.h"
+
+bool ValuePointer::operator==(const ValuePointer &other) const {
+    return fileNumber == other.fileNumber && length == other.length && offset == other.offset;
+}
+
+ValueLog::ValueLog(std::filesystem::path directory, bool reset, uint64_t maxFileSize)
+: directory(std::move(directory)), maxFileSize(maxFileSize) {
+    std::filesystem::create_directories(this->directory);
+    std::set<uint32_t> existing;
+    for (const auto &dirEntry : std::filesystem::directory_iterator(this->directory)){
+        std::smatch match;
+        auto filename = dirEntry.path().filename().string();
+        if (dirEntry.is_regular_file() && std::regex_match(filename, match, valueLogFilenameRegex)){
+            existing.insert(std::stoul(match[1].str()));
+        }
+    }
+
+    if (reset){
+        for (auto fileNumber : existing){
+            std::filesystem::remove(filePath(fileNumber));
+        }
+        existing.clear();
+    }
+
+    if (existing.empty()){
+        startHeadFile(0);
+    } else {
+        oldest = *existing.begin();
+        head = *existing.rbegin();
+        fileNumbers = std::move(existing);
+        openFile(head);
+    }
+}
+
+ValuePointer ValueLog::append(const std::string &key, const DbValue &value) {
+    auto &headFile = files.at(head);
+    headFile.seekp(0, std::ios::end);
+    if (static_cast<uint64_t>(headFile.tellp()) >= maxFileSize){
+        startHeadFile(head + 1);
+        return append(key, value);
+    }
+
+    auto data = dbValueToString(value);
+    RecordHeader header{static_cast<uint32_t>(key.size()), static_cast<uint32_t>(data.size()), value.index()};
+    ValuePointer pointer{head, static_cast<uint32_t>(sizeof(RecordHeader) + key.size() + data.size()),
+                         static_cast<uint64_t>(headFile.tellp())};
+    headFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    headFile.write(key.data(), static_cast<std::streamsize>(key.size()));
+    headFile.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return pointer;
+}
+
+DbValue ValueLog::read(const ValuePointer &pointer) {
+    if (fileNumbers.find(pointer.fileNumber) == fileNumbers.end()){
+        throw std::runtime_error("Value log file " + std::to_string(pointer.fileNumber) + " does not exist");
+    }
+
+    auto &stream = openFile(pointer.fileNumber);
+    auto malformed = [&stream, &pointer](){
+        // The stream is reused, so a bad pointer must not leave it failed for later reads
+        stream.clear();
+        return std::runtime_error("Malformed value log record at offset " + std::to_string(pointer.offset) +
+                                  " of value log file " + std::to_string(pointer.fileNumber));
+    };
+
+    stream.seekg(static_cast<std::streamoff>(pointer.offset));
+    RecordHeader header{};
+    stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!stream || sizeof(RecordHeader) + header.keyLength + header.valueLength != pointer.length){
+        throw malformed();
+    }
+
+    stream.seekg(header.keyLength, std::ios::cur);
+    auto value = readValue(stream, header);
+    if (!stream){
+        throw malformed();
+    }
+    return value;
+}
+
+void ValueLog::sync() {
+    files.at(head).flush();
+}
+
+std::vector<ValueLog::Record> ValueLog::readRecords(uint32_t fileNumber) {
+    if (fileNumber == head){
+        sync();
+    }
+
+    auto &stream = openFile(fileNumber);
+    stream.seekg(0, std::ios::end);
+    uint64_t fileSize = stream.tellg();
+    stream.seekg(0);
+
+    std::vector<Record> records;
+    uint64_t pos = 0;
+    while (pos < fileSize){
+        RecordHeader header{};
+        stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+        std::string key(header.keyLength, '\0');
+        stream.read(key.data(), header.keyLength);
+        stream.seekg(header.valueLength, std::ios::cur);
+        if (!stream){
+            throw std::runtime_error("Value log file " + std::to_string(fileNumber) + " is truncated");
+        }
+
+        uint32_t length = sizeof(RecordHeader) + header.keyLength + header.valueLength;
+        records.push_back({std::move(key), ValuePointer{fileNumber, length, pos}});
+        pos += length;
+    }
+
+    return records;
+}
+
+void ValueLog::removeFile(uint32_t fileNumber) {
+    if (fileNumber == head){
+        throw std::runtime_error("Cannot remove the head of the value log");
+    }
+
+    files.erase(fileNumber);
+    fileNumbers.erase(fileNumber);
+    std::filesystem::remove(filePath(fileNumber));
+    oldest = *fileNumbers.begin();
+}
+
+uint32_t ValueLog::oldestFileNumber() const {
+    return oldest;
+}
+
+uint32_t ValueLog::headFileNumber() const {
+    return head;
+}
+
+size_t ValueLog::numFiles() const {
+    return fileNumbers.size();
+}
+
+const std::set<uint32_t> &ValueLog::getFileNumbers() const {
+    return fileNumbers;
+}
+
+std::filesystem::path ValueLog::filePath(uint32_t fileNumber) const {
+    return directory / fmt::format(fmt::runtime(valueLogFilenameFormat), fileNumber);
+}
+
+std::fstream &ValueLog::openFile(uint32_t fileNumber) {
+    auto it = files.find(fileNumber);
+    if (it != files.end()){
+        return it->second;
+    }
+
+    auto mode = std::ios::in | std::ios::binary;
+    if (fileNumber == head){
+        mode |= std::ios::out | std::ios::app;
+    }
+
+    std::fstream stream(filePath(fileNumber), mode);
+    if (!stream.is_open()){
+        throw std::runtime_error("Could not open value log file " + filePath(fileNumber).string());
+    }
+    return files.emplace(fileNumber, std::move(stream)).first->second;
+}
+
+void ValueLog::startHeadFile(uint32_t fileNumber) {
+    if (!files.empty()){
+        sync();
+        // The old head was opened for appending, reopen it as read only
+        files.erase(head);
+    }
+
+    std::ofstream(filePath(fileNumber), std::ios::app | std::ios::binary);
+    if (fileNumbers.empty()){
+        oldest = fileNumber;
+    }
+    head = fileNumber;
+    fileNumbers.insert(fileNumber);
+    openFile(fileNumber);
+}
+
+DbValue ValueLog::readValue(std::fstream &stream, const RecordHeader &header) {
+    std::string data(header.valueLength, '\0');
+    stream.read(data.data(), header.valueLength);
+    return dbValueFromString(header.typeIndex, data);
+}
@@ -0,0 +1,87 @@
+#ifndef DATAINTENSIVE_VALUELOG_H
+#define DATAINTENSIVE_VALUELOG_H
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <regex>
+#include <set>
+#include <string>
+#include <vector>
+#include "../DatabaseEntry.h"
+#include "SSTableParams.h"
+
+/*
+ * Location of a record in the value log. Stored in SSFiles in place of large values.
+ */
+struct ValuePointer {
+    uint32_t fileNumber;
+    uint32_t length;
+    uint64_t offset;
+
+    bool operator==(const ValuePointer &other) const;
+};
+
+/*
+ * Append-only log holding values that are too large to be copied into SSFiles. The log is split into numbered
+ * files, and only the newest one (the head) is appended to. Each record is:
+ *
+ * RecordHeader
+ * Key
+ * Value
+ *
+ * The key is stored so garbage collection can find out whether a record is still referenced.
+ */
+class ValueLog {
+public:
+    struct Record {
+        std::string key;
+        ValuePointer pointer;
+    };
+
+    ValueLog(std::filesystem::path directory, bool reset, uint64_t maxFileSize = SSTable::maxValueLogFileSize);
+    ValuePointer append(const std::string &key, const DbValue &value);
+    DbValue read(const ValuePointer &pointer);
+    /*
+     * Hands appended records to the OS, without an fsync, like the write ahead log does. Must be called before
+     * anything pointing to them is written, so they survive the process crashing but not the machine.
+     */
+    void sync();
+    /*
+     * Every record in the file, in the order they were appended
+     */
+    std::vector<Record> readRecords(uint32_t fileNumber);
+    void removeFile(uint32_t fileNumber);
+    uint32_t oldestFileNumber() const;
+    uint32_t headFileNumber() const;
+    size_t numFiles() const;
+    const std::set<uint32_t>& getFileNumbers() const;
+    std::filesystem::path filePath(uint32_t fileNumber) const;
+
+private:
+    struct RecordHeader {
+        uint32_t keyLength;
+        uint32_t valueLength;
+        DbValueTypeIndex typeIndex;
+    };
+
+    std::filesystem::path directory;
+    uint64_t maxFileSize;
+    /*
+     * Open streams by file number. The head file stays open for appending, older ones are opened on first read.
+     */
+    std::map<uint32_t, std::fstream> files;
+    std::set<uint32_t> fileNumbers;
+    uint32_t head = 0;
+    uint32_t oldest = 0;
+
+    inline static const std::string valueLogFilenameFormat = "vlog_{}.log";
+    inline static const std::regex valueLogFilenameRegex = std::regex("^vlog_(\\d+).log$");
+
+    std::fstream& openFile(uint32_t fileNumber);
+    void startHeadFile(uint32_t fileNumber);
+    DbValue readValue(std::fstream &stream, const RecordHeader &header);
+};
+
+#endif
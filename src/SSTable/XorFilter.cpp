@@ -0,0 +1,175 @@
+#include "XorFilter.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+/*
+ * Construction fails with a small probability for a given seed, in which case we retry with a different one.
+ * The probability of failing this many times in a row is negligible.
+ */
+static constexpr int maxBuildAttempts = 100;
+
+XorFilter::XorFilter(const DbMemCache *memCache, const std::set<std::string> &tombstones) : seed(0), blockLength(0) {
+    std::vector<uint64_t> keyHashes;
+    keyHashes.reserve(memCache->size() + tombstones.size());
+    for (const auto &entry : *memCache){
+        keyHashes.push_back(hashKey(entry.key));
+    }
+
+    for (const auto &key : tombstones){
+        keyHashes.push_back(hashKey(key));
+    }
+
+    build(std::move(keyHashes));
+}
+
+XorFilter::XorFilter(const std::vector<std::string> &keys) : seed(0), blockLength(0) {
+    std::vector<uint64_t> keyHashes;
+    keyHashes.reserve(keys.size());
+    for (const auto &key : keys){
+        keyHashes.push_back(hashKey(key));
+    }
+
+    build(std::move(keyHashes));
+}
+
+XorFilter::XorFilter(std::vector<uint64_t> keyHashes) : seed(0), blockLength(0) {
+    build(std::move(keyHashes));
+}
+
+XorFilter::XorFilter(const std::vector<uint8_t> &serialized) {
+    if (serialized.size() < sizeof(seed) + sizeof(blockLength)){
+        throw std::runtime_error("Xor filter malformed. Expected at least " + std::to_string(sizeof(seed) + sizeof(blockLength)) + " bytes");
+    }
+
+    std::memcpy(&seed, serialized.data(), sizeof(seed));
+    std::memcpy(&blockLength, serialized.data() + sizeof(seed), sizeof(blockLength));
+    fingerprints.assign(serialized.begin() + sizeof(seed) + sizeof(blockLength), serialized.end());
+    if (fingerprints.size() != 3 * static_cast<size_t>(blockLength)){
+        throw std::runtime_error("Xor filter malformed. Expected " + std::to_string(3 * blockLength) + " fingerprints, found " + std::to_string(fingerprints.size()));
+    }
+}
+
+bool XorFilter::canContainKey(const std::string &key) const {
+    auto hash = mix(hashKey(key), seed);
+    return fingerprint(hash) == (fingerprints[slot(hash, 0)] ^ fingerprints[slot(hash, 1)] ^ fingerprints[slot(hash, 2)]);
+}
+
+std::vector<uint8_t> XorFilter::serialize() const {
+    std::vector<uint8_t> bytes(sizeof(seed) + sizeof(blockLength) + fingerprints.size());
+    std::memcpy(bytes.data(), &seed, sizeof(seed));
+    std::memcpy(bytes.data() + sizeof(seed), &blockLength, sizeof(blockLength));
+    std::copy(fingerprints.begin(), fingerprints.end(), bytes.begin() + sizeof(seed) + sizeof(blockLength));
+    return bytes;
+}
+
+void XorFilter::build(std::vector<uint64_t> keyHashes) {
+    // Duplicate hashes can never be peeled, so they must be removed before building.
+    std::sort(keyHashes.begin(), keyHashes.end());
+    keyHashes.erase(std::unique(keyHashes.begin(), keyHashes.end()), keyHashes.end());
+
+    // A load factor of 1.23 slots per key is the threshold above which peeling succeeds with high probability.
+    size_t capacity = 32 + static_cast<size_t>(1.23 * static_cast<double>(keyHashes.size()));
+    blockLength = capacity / 3;
+
+    for (int attempt = 0; attempt < maxBuildAttempts; attempt++){
+        seed = mix(attempt, 0x9e3779b97f4a7c15ULL);
+        if (tryBuild(keyHashes)){
+            return;
+        }
+    }
+
+    throw std::runtime_error("Failed to build xor filter for " + std::to_string(keyHashes.size()) + " keys");
+}
+
+bool XorFilter::tryBuild(const std::vector<uint64_t> &keyHashes) {
+    size_t numSlots = 3 * static_cast<size_t>(blockLength);
+    std::vector<uint64_t> xorMasks(numSlots, 0);
+    std::vector<uint32_t> counts(numSlots, 0);
+    for (auto keyHash : keyHashes){
+        auto hash = mix(keyHash, seed);
+        for (int i = 0; i < 3; i++){
+            auto s = slot(hash, i);
+            xorMasks[s] ^= hash;
+            counts[s]++;
+        }
+    }
+
+    /*
+     * Peel slots that are used by a single key. Once a key is peeled it is removed from its other two slots,
+     * which may leave them with a single key as well. The order in which keys are peeled is recorded so we
+     * can assign fingerprints in reverse.
+     */
+    std::vector<uint32_t> singletons;
+    for (uint32_t s = 0; s < numSlots; s++){
+        if (counts[s] == 1){
+            singletons.push_back(s);
+        }
+    }
+
+    std::vector<std::pair<uint64_t, uint32_t>> peeled;
+    peeled.reserve(keyHashes.size());
+    while (!singletons.empty()){
+        auto s = singletons.back();
+        singletons.pop_back();
+        if (counts[s] != 1){
+            continue;
+        }
+
+        auto hash = xorMasks[s];
+        peeled.emplace_back(hash, s);
+        for (int i = 0; i < 3; i++){
+            auto other = slot(hash, i);
+            xorMasks[other] ^= hash;
+            counts[other]--;
+            if (counts[other] == 1){
+                singletons.push_back(other);
+            }
+        }
+    }
+
+    if (peeled.size() != keyHashes.size()){
+        return false;
+    }
+
+    fingerprints.assign(numSlots, 0);
+    for (auto it = peeled.rbegin(); it != peeled.rend(); it++){
+        auto [hash, s] = *it;
+        fingerprints[s] = fingerprint(hash) ^ fingerprints[slot(hash, 0)] ^ fingerprints[slot(hash, 1)] ^ fingerprints[slot(hash, 2)];
+    }
+
+    return true;
+}
+
+uint32_t XorFilter::slot(uint64_t hash, int index) const {
+    // Each of the three slots is taken from a different part of the hash, and lands in its own third of the array.
+    uint64_t rotated = index == 0 ? hash : (hash << (21 * index)) | (hash >> (64 - 21 * index));
+    auto reduced = static_cast<uint32_t>((static_cast<uint64_t>(static_cast<uint32_t>(rotated)) * blockLength) >> 32);
+    return reduced + index * blockLength;
+}
+
+uint64_t XorFilter::hashKey(const std::string &key) {
+    // 64-bit FNV-1a. Filters are persisted in SSFiles, so this must be deterministic across runs and platforms.
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : key){
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+uint64_t XorFilter::mix(uint64_t hash, uint64_t seed) {
+    // MurmurHash3 finalizer
+    hash += seed;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+XorFilter::FingerprintType XorFilter::fingerprint(uint64_t hash) {
+    return static_cast<FingerprintType>(hash ^ (hash >> 32));
+}
@@ -0,0 +1,45 @@
+#ifndef DATAINTENSIVE_XORFILTER_H
+#define DATAINTENSIVE_XORFILTER_H
+
+#include <set>
+#include "DbMemCache.h"
+#include "KeyFilter.h"
+
+/*
+ * 8-bit xor filter (Graf & Lemire, "Xor Filters: Faster and Smaller Than Bloom and Cuckoo Filters").
+ *
+ * Every key maps to three slots, one in each third of the fingerprint array, and the filter is built so that the
+ * xor of those three slots equals the key's 8-bit fingerprint. This gives a false positive rate of 2^-8 (~0.4%)
+ * with ~9.84 bits per key. For the same 0.4%, a bloom filter with SSTable::bloomFilterHashes (3) hashes needs
+ * ~17.5 bits per key, and even with the optimal 8 hashes it needs ~11.5. The trade-off is that the filter can only
+ * be built once the whole key set is known, which is always the case for an SSFile.
+ */
+class XorFilter : public KeyFilter {
+public:
+    using FingerprintType = uint8_t;
+
+    XorFilter(const DbMemCache* memCache, const std::set<std::string> &tombstones);
+    explicit XorFilter(const std::vector<std::string> &keys);
+    explicit XorFilter(const std::vector<uint8_t> &serialized);
+    /*
+     * Builds the filter from hashKey() of every key, for callers that see each key once and don't keep them around
+     */
+    explicit XorFilter(std::vector<uint64_t> keyHashes);
+    bool canContainKey(const std::string &key) const override;
+    std::vector<uint8_t> serialize() const override;
+    static uint64_t hashKey(const std::string &key);
+
+private:
+    uint64_t seed;
+    uint32_t blockLength;
+    std::vector<FingerprintType> fingerprints;
+
+    void build(std::vector<uint64_t> keyHashes);
+    bool tryBuild(const std::vector<uint64_t> &keyHashes);
+    uint32_t slot(uint64_t hash, int index) const;
+    static uint64_t mix(uint64_t hash, uint64_t seed);
+    static FingerprintType fingerprint(uint64_t hash);
+};
+
+
+#endif
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include "../Workload.h"
+#include "../SSTable/EytzingerIndex.h"
+#include "../SSTable/PaddedKeySearch.h"
+#include "../SSTable/SSTableParams.h"
+
+class EytzingerIndexTest : public testing::Test {
+protected:
+    EytzingerIndexTest() {
+        seed = time(nullptr);
+        std::cout << "seed for reproducibility " << std::to_string(seed) << "\n";
+        workloadGenerator = std::make_unique<WorkloadGenerator>(seed, SSTable::maxKeySize);
+    }
+
+    std::unique_ptr<WorkloadGenerator> workloadGenerator;
+    unsigned int seed;
+};
+
+TEST_F(EytzingerIndexTest, testFind){
+    const size_t fixedKeySize = 16;
+    const size_t pairLength = fixedKeySize + sizeof(uint64_t);
+    // Cover sizes where the last level of the tree is empty, partially filled and full
+    for (size_t numKeys : {0, 1, 2, 3, 7, 8, 100, 1023, 1024}){
+        std::set<std::string> keySet;
+        while (keySet.size() < numKeys){
+            keySet.insert(workloadGenerator->generateRandomKeyValues(1, fixedKeySize).front().first);
+        }
+
+        std::string pairs;
+        uint64_t position = 0;
+        for (const auto &key : keySet){
+            pairs += PaddedKeySearch::pad(key, fixedKeySize);
+            pairs.append(reinterpret_cast<const char*>(&position), sizeof(position));
+            position++;
+        }
+
+        EytzingerIndex index(pairs.data(), numKeys, pairLength, fixedKeySize);
+        position = 0;
+        for (const auto &key : keySet){
+            auto pair = index.find(PaddedKeySearch::pad(key, fixedKeySize).data());
+            ASSERT_NE(pair, nullptr);
+            uint64_t found;
+            std::memcpy(&found, pair + fixedKeySize, sizeof(found));
+            ASSERT_EQ(found, position);
+            position++;
+        }
+
+        for (const auto &[key, value] : workloadGenerator->generateRandomKeyValues(100, fixedKeySize)){
+            if (keySet.count(key) == 0){
+                ASSERT_EQ(index.find(PaddedKeySearch::pad(key, fixedKeySize).data()), nullptr);
+            }
+        }
+    }
+}
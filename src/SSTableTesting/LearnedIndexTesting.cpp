@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include "../Workload.h"
+#include "../SSTable/LearnedIndex.h"
+#include "../SSTable/SSTableParams.h"
+
+class LearnedIndexTest : public testing::Test {
+protected:
+    LearnedIndexTest() {
+        seed = time(nullptr);
+        std::cout << "seed for reproducibility " << std::to_string(seed) << "\n";
+        workloadGenerator = std::make_unique<WorkloadGenerator>(seed, SSTable::maxKeySize);
+    }
+
+    static void assertKeysInWindow(const LearnedIndex &learnedIndex, const std::vector<std::string> &sortedKeys){
+        for (size_t i = 0; i < sortedKeys.size(); i++){
+            auto window = learnedIndex.predict(sortedKeys[i]);
+            ASSERT_LE(window.lo, i);
+            ASSERT_GT(window.hi, i);
+        }
+    }
+
+    std::unique_ptr<WorkloadGenerator> workloadGenerator;
+    unsigned int seed;
+};
+
+TEST_F(LearnedIndexTest, testSequentialIds){
+    std::vector<std::string> keys;
+    for (int id = 0; id < 5000; id++){
+        auto digits = std::to_string(id * 3);
+        keys.push_back("user:" + std::string(10 - digits.size(), '0') + digits);
+    }
+
+    LearnedIndex learnedIndex(keys, SSTable::learnedIndexMaxError);
+    assertKeysInWindow(learnedIndex, keys);
+    // Decimal ids are not linear byte-wise (each carry skips '9' to '0'), but still need few segments
+    ASSERT_LT(learnedIndex.getSegments().size(), keys.size() / 10);
+    for (const auto &key : keys){
+        auto window = learnedIndex.predict(key);
+        ASSERT_LE(window.hi - window.lo, 2 * SSTable::learnedIndexMaxError + 1);
+    }
+}
+
+TEST_F(LearnedIndexTest, testRandomKeys){
+    std::vector<std::string> keys;
+    for (const auto &[key, value] : workloadGenerator->generateRandomKeyValues(5000, 64)){
+        keys.push_back(key);
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    LearnedIndex learnedIndex(keys, SSTable::learnedIndexMaxError);
+    assertKeysInWindow(learnedIndex, keys);
+
+    LearnedIndex deserialized(learnedIndex.getCommonPrefixLength(), learnedIndex.getSegments(), keys.size());
+    assertKeysInWindow(deserialized, keys);
+}
+
+TEST_F(LearnedIndexTest, testKeysSharingNumber){
+    // Keys that only differ after the first 8 bytes past the common prefix all map to the same number
+    std::vector<std::string> keys;
+    for (int group = 0; group < 10; group++){
+        for (int i = 0; i < 100; i++){
+            keys.push_back("p" + std::to_string(group) + "_______" + std::to_string(1000 + i));
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+
+    LearnedIndex learnedIndex(keys, 2);
+    assertKeysInWindow(learnedIndex, keys);
+}
@@ -1,11 +1,22 @@
 #include <gtest/gtest.h>
+#include <thread>
 #include "../DatabaseEntry.h"
 #include "../SSTable/BST.hpp"
+#include "../SSTable/ConcurrentSkipList.hpp"
+#include "../SSTable/AdaptiveRadixTree.hpp"
+#include "../SSTable/ArenaMemCache.h"
+#include "../SSTable/AVLTree.hpp"
+#include "../SSTable/BulkLoadMemCache.hpp"
 #include "../Workload.h"
 #include "../SSTable/DbMemCache.h"
 #include "../SSTable/SSTableParams.h"
 
-class MemcacheTest : public testing::Test {
+using MemCacheFactory = std::function<std::unique_ptr<DbMemCache>()>;
+
+/*
+ * Runs every test against each memcache implementation
+ */
+class MemcacheTest : public testing::TestWithParam<std::pair<std::string, MemCacheFactory>> {
 protected:
     MemcacheTest() {
         seed = time(nullptr);
@@ -19,7 +30,7 @@ protected:
     }
 
     void initializeMemCache(){
-        memCache = std::make_unique<BST<std::string, DbValue>>();
+        memCache = GetParam().second();
     }
 
     std::unique_ptr<DbMemCache> memCache;
@@ -27,7 +38,18 @@ protected:
     unsigned int seed;
 };
 
-TEST_F(MemcacheTest, testCorrectness){
+INSTANTIATE_TEST_SUITE_P(MemCaches, MemcacheTest, testing::Values(
+        std::make_pair(std::string("BST"), MemCacheFactory([](){ return std::make_unique<BST<std::string, DbValue>>(); })),
+        std::make_pair(std::string("ConcurrentSkipList"), MemCacheFactory([](){ return std::make_unique<ConcurrentSkipList<std::string, DbValue>>(); })),
+        std::make_pair(std::string("AdaptiveRadixTree"), MemCacheFactory([](){ return std::make_unique<AdaptiveRadixTree<DbValue>>(); })),
+        std::make_pair(std::string("ArenaMemCache"), MemCacheFactory([](){ return std::make_unique<ArenaMemCache>(); })),
+        std::make_pair(std::string("AVLTree"), MemCacheFactory([](){ return std::make_unique<AVLTree<std::string, DbValue>>(); })),
+        std::make_pair(std::string("BSTHashIndex"), MemCacheFactory([](){ return std::make_unique<BST<std::string, DbValue>>(true); })),
+        std::make_pair(std::string("AVLTreeHashIndex"), MemCacheFactory([](){ return std::make_unique<AVLTree<std::string, DbValue>>(true); })),
+        std::make_pair(std::string("BulkLoadMemCache"), MemCacheFactory([](){ return std::make_unique<BulkLoadMemCache<std::string, DbValue>>(); }))
+), [](const auto &info){ return info.param.first; });
+
+TEST_P(MemcacheTest, testCorrectness){
     std::map<std::string, DbValue> mirror;
     auto workload = workloadGenerator->generateRandomWorkload(20000, 20);
     for (auto &action : workload){
@@ -51,7 +73,7 @@ TEST_F(MemcacheTest, testCorrectness){
     }
 }
 
-TEST_F(MemcacheTest, testTraverseSorted){
+TEST_P(MemcacheTest, testTraverseSorted){
     std::map<std::string, DbValue> mirror;
     auto workload = workloadGenerator->generateRandomWorkload(20000, 20);
     for (auto &action : workload){
@@ -73,3 +95,241 @@ TEST_F(MemcacheTest, testTraverseSorted){
         ++it;
     });
 }
+
+TEST_P(MemcacheTest, testIterator){
+    ASSERT_TRUE(memCache->begin() == memCache->end());
+
+    std::map<std::string, DbValue> mirror;
+    auto workload = workloadGenerator->generateRandomWorkload(20000, 20);
+    for (auto &action : workload){
+        switch (action.operation) {
+            case Operation::INSERT:
+                mirror[action.key] = action.value;
+                memCache->insert(action.key, action.value);
+                break;
+            case Operation::DELETE:
+                mirror.erase(action.key);
+                memCache->remove(action.key);
+                break;
+            case Operation::GET:
+                break;
+        }
+    }
+
+    auto it = mirror.begin();
+    for (const auto &[key, value] : *memCache){
+        ASSERT_NE(it, mirror.end());
+        ASSERT_EQ(it->first, key);
+        ASSERT_EQ(it->second, value);
+        ++it;
+    }
+    ASSERT_EQ(it, mirror.end());
+}
+
+TEST_P(MemcacheTest, testClear){
+    for (const auto& [key, value] : workloadGenerator->generateRandomKeyValues(1000, 64)){
+        memCache->insert(key, value);
+    }
+
+    memCache->clear();
+    ASSERT_EQ(memCache->size(), 0);
+    memCache->traverseSorted([](const auto &key, const auto &value){
+        FAIL() << "Expected memcache to be empty";
+    });
+
+    memCache->insert("key", 1);
+    ASSERT_EQ(memCache->get("key"), DbValue(1));
+    ASSERT_EQ(memCache->size(), 1);
+}
+
+TEST_P(MemcacheTest, testMemoryUsage){
+    for (int i = 0; i < 100; i++){
+        memCache->insert("key" + std::to_string(i), std::string(1000, 'v'));
+    }
+    auto fullUsage = memCache->memoryUsage();
+    ASSERT_GE(fullUsage, 100 * 1000);
+
+    // Overwriting with small values must not count the large ones twice
+    for (int i = 0; i < 100; i++){
+        memCache->insert("key" + std::to_string(i), i);
+    }
+    ASSERT_LT(memCache->memoryUsage(), 2 * fullUsage);
+
+    memCache->clear();
+    ASSERT_LT(memCache->memoryUsage(), fullUsage);
+}
+
+TEST(ConcurrentSkipListTest, testConcurrentInserts){
+    ConcurrentSkipList<std::string, DbValue> skipList;
+    const int numThreads = 8, keysPerThread = 5000;
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < numThreads; thread++){
+        threads.emplace_back([&skipList, thread](){
+            for (int i = 0; i < keysPerThread; i++){
+                // Half of the keys are written by every thread, the other half only by this one
+                auto key = i % 2 == 0 ? "shared" + std::to_string(i) : "thread" + std::to_string(thread) + ":" + std::to_string(i);
+                skipList.insert(key, i);
+                ASSERT_TRUE(skipList.get(key).has_value());
+            }
+        });
+    }
+    for (auto &thread : threads){
+        thread.join();
+    }
+
+    ASSERT_EQ(skipList.size(), keysPerThread / 2 + numThreads * keysPerThread / 2);
+    std::string previous;
+    size_t traversed = 0;
+    skipList.traverseSorted([&](const std::string &key, const DbValue &value){
+        ASSERT_LT(previous, key);
+        previous = key;
+        traversed++;
+    });
+    ASSERT_EQ(traversed, skipList.size());
+}
+
+TEST(ConcurrentSkipListTest, testConcurrentRemoves){
+    ConcurrentSkipList<std::string, DbValue> skipList;
+    const int numKeys = 10000;
+    for (int i = 0; i < numKeys; i++){
+        skipList.insert(std::to_string(i), i);
+    }
+
+    // Every thread tries to remove every key, exactly one remove per key may succeed
+    std::atomic<int> removed = 0;
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 4; thread++){
+        threads.emplace_back([&](){
+            for (int i = 0; i < numKeys; i++){
+                removed += skipList.remove(std::to_string(i));
+            }
+        });
+    }
+    for (auto &thread : threads){
+        thread.join();
+    }
+
+    ASSERT_EQ(removed, numKeys);
+    ASSERT_EQ(skipList.size(), 0);
+}
+
+TEST(AdaptiveRadixTreeTest, testNodeGrowthAndPrefixKeys){
+    AdaptiveRadixTree<DbValue> tree;
+    std::map<std::string, DbValue> mirror;
+    // Every byte value after a shared prefix grows the node below it up to a Node256, and keys that are
+    // prefixes of each other end at inner nodes
+    for (int byte = 1; byte < 256; byte++){
+        for (const auto &key : {"shared/" + std::string(1, static_cast<char>(byte)), "shared/" + std::string(1, static_cast<char>(byte)) + "suffix"}){
+            mirror[key] = byte;
+            tree.insert(key, byte);
+        }
+    }
+    mirror["shared/"] = 0;
+    tree.insert("shared/", 0);
+    mirror["shared"] = -1;
+    tree.insert("shared", -1);
+
+    auto assertMatchesMirror = [&](){
+        ASSERT_EQ(tree.size(), mirror.size());
+        auto it = mirror.begin();
+        tree.traverseSorted([&](const std::string &key, const DbValue &value){
+            ASSERT_EQ(key, it->first);
+            ASSERT_EQ(value, it->second);
+            it++;
+        });
+        for (const auto &[key, value] : mirror){
+            ASSERT_EQ(tree.get(key), value);
+        }
+    };
+    assertMatchesMirror();
+
+    // Removing shrinks nodes back down and collapses single child paths
+    for (int byte = 1; byte < 256; byte++){
+        auto key = "shared/" + std::string(1, static_cast<char>(byte));
+        ASSERT_TRUE(tree.remove(byte % 2 ? key : key + "suffix"));
+        mirror.erase(byte % 2 ? key : key + "suffix");
+        if (byte % 3 == 0){
+            ASSERT_TRUE(tree.remove(byte % 2 ? key + "suffix" : key));
+            mirror.erase(byte % 2 ? key + "suffix" : key);
+        }
+    }
+    ASSERT_FALSE(tree.remove("shared/x/missing"));
+    ASSERT_FALSE(tree.get("sha").has_value());
+    assertMatchesMirror();
+}
+
+TEST(ArenaMemCacheTest, testClearReusesArena){
+    ArenaMemCache memCache(4096);
+    for (int round = 0; round < 3; round++){
+        for (int i = 0; i < 1000; i++){
+            memCache.insert("key" + std::to_string(i), std::string(100, 'v'));
+        }
+        ASSERT_GT(memCache.memoryUsage(), 4096);
+        memCache.clear();
+        ASSERT_EQ(memCache.memoryUsage(), 4096);
+        ASSERT_FALSE(memCache.get("key0").has_value());
+    }
+}
+
+TEST(ArenaMemCacheTest, testValueTypes){
+    ArenaMemCache memCache;
+    std::vector<DbValue> values = {-7, 1L << 40, 0.1, true, std::string("value"), std::string()};
+    for (size_t i = 0; i < values.size(); i++){
+        memCache.insert(std::to_string(i), values[i]);
+    }
+    for (size_t i = 0; i < values.size(); i++){
+        ASSERT_EQ(memCache.get(std::to_string(i)), values[i]);
+    }
+}
+
+TEST(AVLTreeTest, testSortedInsertsStayBalanced){
+    AVLTree<int, int> tree;
+    const int numKeys = 1 << 16;
+    for (int i = 0; i < numKeys; i++){
+        tree.insert(i, i);
+    }
+    // An AVL tree with n nodes is at most about 1.44 * log2(n) high
+    ASSERT_LE(tree.height(), 24);
+
+    for (int i = 0; i < numKeys; i += 2){
+        ASSERT_TRUE(tree.remove(i));
+    }
+    ASSERT_EQ(tree.size(), numKeys / 2);
+    ASSERT_LE(tree.height(), 23);
+
+    int expected = 1;
+    tree.traverseSorted([&expected](const int &key, const int &value){
+        ASSERT_EQ(key, expected);
+        expected += 2;
+    });
+    ASSERT_EQ(expected, numKeys + 1);
+}
+
+TEST(BulkLoadMemCacheTest, testParallelSortKeepsLastWrite){
+    // Enough entries for every thread to sort its own run
+    const int numThreads = 4, numEntries = numThreads * SSTable::parallelSortMinRun * 2, numKeys = 5000;
+    BulkLoadMemCache<std::string, DbValue> memCache(numThreads);
+    std::map<std::string, DbValue> mirror;
+    std::mt19937 random(42);
+    for (int i = 0; i < numEntries; i++){
+        auto key = "key" + std::to_string(random() % numKeys);
+        if (i % 10 == 0){
+            ASSERT_EQ(mirror.erase(key) >= 1, memCache.remove(key));
+            continue;
+        }
+        mirror[key] = i;
+        memCache.insert(key, i);
+    }
+
+    // Removes must not sort, so everything is sorted at once here
+    ASSERT_EQ(memCache.lastSortThreads(), 0);
+    ASSERT_EQ(memCache.size(), mirror.size());
+    ASSERT_EQ(memCache.lastSortThreads(), numThreads);
+    auto it = mirror.begin();
+    for (const auto &[key, value] : memCache){
+        ASSERT_EQ(key, it->first);
+        ASSERT_EQ(value, it->second);
+        ++it;
+    }
+    ASSERT_EQ(it, mirror.end());
+}
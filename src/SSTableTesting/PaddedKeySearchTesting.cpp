@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include "../Workload.h"
+#include "../SSTable/PaddedKeySearch.h"
+#include "../SSTable/SSTableParams.h"
+
+class PaddedKeySearchTest : public testing::Test {
+protected:
+    PaddedKeySearchTest() {
+        seed = time(nullptr);
+        std::cout << "seed for reproducibility " << std::to_string(seed) << "\n";
+        workloadGenerator = std::make_unique<WorkloadGenerator>(seed, SSTable::maxKeySize);
+    }
+
+    std::unique_ptr<WorkloadGenerator> workloadGenerator;
+    unsigned int seed;
+};
+
+static int sign(int x){
+    return (x > 0) - (x < 0);
+}
+
+TEST_F(PaddedKeySearchTest, testCompareMatchesStringOrder){
+    for (size_t fixedKeySize : {8, 16, 32, 64, 1024}){
+        auto keyValues = workloadGenerator->generateRandomKeyValues(2000, fixedKeySize);
+        for (size_t i = 1; i < keyValues.size(); i++){
+            const auto &lhs = keyValues[i - 1].first;
+            // Share a prefix with lhs half of the time, so differences are found past the first vector
+            auto rhs = i % 2 ? lhs.substr(0, lhs.size() / 2) + keyValues[i].first : keyValues[i].first;
+            rhs.resize(std::min(rhs.size(), fixedKeySize));
+
+            auto paddedLhs = PaddedKeySearch::pad(lhs, fixedKeySize);
+            auto paddedRhs = PaddedKeySearch::pad(rhs, fixedKeySize);
+            ASSERT_EQ(sign(PaddedKeySearch::compare(paddedLhs.data(), paddedRhs.data(), fixedKeySize)), sign(lhs.compare(rhs)));
+            ASSERT_EQ(PaddedKeySearch::compare(paddedLhs.data(), paddedLhs.data(), fixedKeySize), 0);
+        }
+    }
+}
+
+TEST_F(PaddedKeySearchTest, testLowerBound){
+    const size_t fixedKeySize = 16;
+    const size_t pairLength = fixedKeySize + 8;
+    std::vector<std::string> keys;
+    for (const auto &[key, value] : workloadGenerator->generateRandomKeyValues(1000, fixedKeySize)){
+        keys.push_back(key);
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    std::string pairs;
+    for (const auto &key : keys){
+        pairs += PaddedKeySearch::pad(key, pairLength);
+    }
+
+    for (const auto &[probe, value] : workloadGenerator->generateRandomKeyValues(1000, fixedKeySize)){
+        auto expected = std::lower_bound(keys.begin(), keys.end(), probe) - keys.begin();
+        auto padded = PaddedKeySearch::pad(probe, fixedKeySize);
+        ASSERT_EQ(PaddedKeySearch::lowerBound(pairs.data(), keys.size(), pairLength, padded.data(), fixedKeySize), expected);
+    }
+
+    for (size_t i = 0; i < keys.size(); i++){
+        auto padded = PaddedKeySearch::pad(keys[i], fixedKeySize);
+        ASSERT_EQ(PaddedKeySearch::lowerBound(pairs.data(), keys.size(), pairLength, padded.data(), fixedKeySize), i);
+    }
+}
@@ -2,6 +2,7 @@
 #include "../DatabaseEntry.h"
 #include "../SSTable/BST.hpp"
 #include "../SSTable/SSFileCreator.h"
+#include "../SSTable/SSFileCursor.h"
 #include "../Workload.h"
 
 class SSFileTest : public testing::Test {
@@ -21,6 +22,33 @@ protected:
         memCache = std::make_unique<BST<std::string, DbValue>>();
     }
 
+    /*
+     * Checks that every key in mirror is found with its value, every tombstone is found as one, and keys that
+     * were never written are not found
+     */
+    void assertFileMatches(SSFile *ssFile, const std::map<std::string, DbValue> &mirror, const std::set<std::string> &tombstones){
+        for (const auto& [key, val] : mirror) {
+            auto read = ssFile->get(key);
+            ASSERT_EQ(read.type, KEY_FOUND);
+            auto value = read.value.value();
+            if (std::holds_alternative<double>(val)) {
+                ASSERT_NEAR(std::get<double>(val), std::get<double>(value), 0.00001);
+                continue;
+            }
+
+            ASSERT_EQ(val, value);
+        }
+
+        for (const auto& key : tombstones){
+            ASSERT_EQ(ssFile->get(key).type, KEY_TOMBSTONE);
+        }
+
+        auto keyValuesNotInserted = workloadGenerator->generateRandomKeyValues(30, 256);
+        for (const auto& [key, val] : keyValuesNotInserted){
+            ASSERT_EQ(ssFile->get(key).type, KEY_NOT_FOUND);
+        }
+    }
+
     std::unique_ptr<DbMemCache> memCache;
     std::unique_ptr<WorkloadGenerator> workloadGenerator;
     unsigned int seed;
@@ -59,52 +87,326 @@ TEST_F(SSFileTest, testNoFilter) {
     auto workload = workloadGenerator->generateRandomWorkload(20000, 20);
     populate(workload, mirror, tombstones, memCache.get());
     auto ssFile = SSFileCreator::newFile(fileDirectory, 0, 0, memCache.get(), tombstones);
-    for (const auto& [key, val] : mirror) {
-        auto read = ssFile->get(key);
-        ASSERT_EQ(read.type, KEY_FOUND);
-        auto value = read.value.value();
-        if (std::holds_alternative<double>(val)) {
-            ASSERT_NEAR(std::get<double>(val), std::get<double>(value), 0.00001);
-            continue;
-        }
+    assertFileMatches(ssFile.get(), mirror, tombstones);
+}
 
-        ASSERT_EQ(val, value);
-    }
+TEST_F(SSFileTest, testFilter) {
+    std::map<std::string, DbValue> mirror;
+    std::set<std::string> tombstones;
+    auto workload = workloadGenerator->generateRandomWorkload(20000, 20);
+    populate(workload, mirror, tombstones, memCache.get());
+    auto ssFile = SSFileCreator::newFile(fileDirectory, 0, SSTable::bloomFilterBits, memCache.get(), tombstones);
+    assertFileMatches(ssFile.get(), mirror, tombstones);
+}
 
-    for (const auto& key : tombstones){
-        ASSERT_EQ(ssFile->get(key).type, KEY_TOMBSTONE);
+TEST_F(SSFileTest, testXorFilter) {
+    std::map<std::string, DbValue> mirror;
+    std::set<std::string> tombstones;
+    auto workload = workloadGenerator->generateRandomWorkload(20000, 20);
+    populate(workload, mirror, tombstones, memCache.get());
+    SSFileOptions options;
+    options.filterType = FilterType::XOR;
+    auto ssFile = SSFileCreator::newFile(fileDirectory, 0, options, memCache.get(), tombstones);
+    assertFileMatches(ssFile.get(), mirror, tombstones);
+}
+
+TEST_F(SSFileTest, testScanPrefix) {
+    std::map<std::string, DbValue> mirror;
+    std::set<std::string> tombstones;
+    auto workload = workloadGenerator->generateRandomWorkload(20000, 20);
+    for (auto &action : workload){
+        action.key = "tenant" + std::to_string(action.key.size() % 10) + ":" + action.key.substr(0, 200);
     }
+    populate(workload, mirror, tombstones, memCache.get());
 
-    auto keyValuesNotInserted = workloadGenerator->generateRandomKeyValues(30, 256);
-    for (const auto& [key, val] : keyValuesNotInserted){
-        ASSERT_EQ(ssFile->get(key).type, KEY_NOT_FOUND);
+    SSFileOptions options;
+    options.prefixExtractor = PrefixExtractor::upToDelimiter(':');
+    auto ssFile = SSFileCreator::newFile(fileDirectory, 0, options, memCache.get(), tombstones);
+    for (int tenant = 0; tenant < 10; tenant++){
+        auto prefix = "tenant" + std::to_string(tenant) + ":";
+        auto scanned = ssFile->scanPrefix(prefix);
+        auto it = scanned.begin();
+        for (auto mirrorIt = mirror.lower_bound(prefix); mirrorIt != mirror.end() && mirrorIt->first.compare(0, prefix.size(), prefix) == 0; mirrorIt++){
+            while (it != scanned.end() && it->second.type == KEY_TOMBSTONE){
+                ASSERT_TRUE(tombstones.count(it->first));
+                it++;
+            }
+            ASSERT_NE(it, scanned.end());
+            ASSERT_EQ(it->first, mirrorIt->first);
+            ASSERT_EQ(it->second.type, KEY_FOUND);
+            it++;
+        }
     }
+
+    ASSERT_EQ(ssFile->scanPrefix("").size(), mirror.size() + tombstones.size());
+    ASSERT_FALSE(ssFile->canContainPrefix("othertenant:"));
+    ASSERT_TRUE(ssFile->scanPrefix("othertenant:").empty());
+    // Prefixes without the delimiter cannot use the filter
+    ASSERT_TRUE(ssFile->canContainPrefix("other"));
 }
 
-TEST_F(SSFileTest, testFilter) {
+TEST_F(SSFileTest, testMultiGet) {
     std::map<std::string, DbValue> mirror;
     std::set<std::string> tombstones;
     auto workload = workloadGenerator->generateRandomWorkload(20000, 20);
     populate(workload, mirror, tombstones, memCache.get());
     auto ssFile = SSFileCreator::newFile(fileDirectory, 0, SSTable::bloomFilterBits, memCache.get(), tombstones);
-    for (const auto& [key, val] : mirror) {
-        auto read = ssFile->get(key);
-        ASSERT_EQ(read.type, KEY_FOUND);
-        auto value = read.value.value();
-        if (std::holds_alternative<double>(val)) {
-            ASSERT_NEAR(std::get<double>(val), std::get<double>(value), 0.00001);
+
+    std::vector<std::string> keys;
+    for (const auto& [key, val] : mirror){
+        keys.push_back(key);
+    }
+    keys.insert(keys.end(), tombstones.begin(), tombstones.end());
+    for (const auto& [key, val] : workloadGenerator->generateRandomKeyValues(30, 256)){
+        keys.push_back(key);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    auto reads = ssFile->multiGet(keys);
+    ASSERT_EQ(reads.size(), keys.size());
+    for (size_t i = 0; i < keys.size(); i++){
+        auto read = ssFile->get(keys[i]);
+        ASSERT_EQ(reads[i].type, read.type);
+        ASSERT_EQ(reads[i].value.has_value(), read.value.has_value());
+        if (read.value.has_value()){
+            ASSERT_EQ(reads[i].value.value(), read.value.value());
+        }
+    }
+}
+
+TEST_F(SSFileTest, testKeyIndexInMemory) {
+    std::map<std::string, DbValue> mirror;
+    std::set<std::string> tombstones;
+    auto workload = workloadGenerator->generateRandomWorkload(20000, 20);
+    populate(workload, mirror, tombstones, memCache.get());
+    SSFileOptions options;
+    options.keyIndexInMemory = true;
+    auto ssFile = SSFileCreator::newFile(fileDirectory, 0, options, memCache.get(), tombstones);
+    assertFileMatches(ssFile.get(), mirror, tombstones);
+
+    ASSERT_EQ(ssFile->scanPrefix("").size(), mirror.size() + tombstones.size());
+}
+
+TEST_F(SSFileTest, testEytzingerKeyIndex) {
+    std::map<std::string, DbValue> mirror;
+    std::set<std::string> tombstones;
+    auto workload = workloadGenerator->generateRandomWorkload(20000, 20);
+    populate(workload, mirror, tombstones, memCache.get());
+    SSFileOptions options;
+    options.eytzingerKeyIndex = true;
+    auto ssFile = SSFileCreator::newFile(fileDirectory, 0, options, memCache.get(), tombstones);
+    assertFileMatches(ssFile.get(), mirror, tombstones);
+}
+
+TEST_F(SSFileTest, testLearnedIndex) {
+    std::map<std::string, DbValue> mirror;
+    std::set<std::string> tombstones;
+    auto workload = workloadGenerator->generateRandomWorkload(20000, 20);
+    populate(workload, mirror, tombstones, memCache.get());
+    for (bool keyIndexInMemory : {false, true}){
+        SSFileOptions options;
+        options.learnedIndex = true;
+        options.keyIndexInMemory = keyIndexInMemory;
+        auto ssFile = SSFileCreator::newFile(fileDirectory, 0, options, memCache.get(), tombstones);
+        assertFileMatches(ssFile.get(), mirror, tombstones);
+    }
+}
+
+TEST_F(SSFileTest, testWriterLargerThanBuffer) {
+    SSFileOptions options;
+    options.filterType = FilterType::XOR;
+    options.learnedIndex = true;
+    auto writer = SSFileCreator::newWriter(fileDirectory, 0, options);
+    std::map<std::string, DbValue> mirror;
+    std::set<std::string> tombstones;
+    // Values add up to a few write buffers, so entries straddle buffer boundaries
+    for (int i = 0; i < 3000; i++){
+        auto number = std::to_string(i);
+        auto key = "key" + std::string(6 - number.size(), '0') + number;
+        if (i % 7 == 0){
+            tombstones.insert(key);
+            writer->addTombstone(key);
+            continue;
+        }
+
+        DbValue value = std::string(1000 + i % 37, static_cast<char>('a' + i % 26));
+        mirror[key] = value;
+        writer->add(key, value);
+    }
+
+    ASSERT_EQ(writer->numEntries(), 3000);
+    auto ssFile = writer->finish();
+    assertFileMatches(ssFile.get(), mirror, tombstones);
+    ASSERT_EQ(ssFile->get("key003000").type, KEY_NOT_FOUND);
+    ASSERT_EQ(ssFile->scanPrefix("").size(), 3000);
+}
+
+TEST_F(SSFileTest, testWriterRejectsUnsortedKeys) {
+    auto writer = SSFileCreator::newWriter(fileDirectory, 0, SSFileOptions{});
+    writer->add("b", 1);
+    ASSERT_THROW(writer->add("a", 1), std::runtime_error);
+    ASSERT_THROW(writer->addTombstone("b"), std::runtime_error);
+    ASSERT_THROW(writer->add(std::string(SSTable::maxKeySize + 1, 'c'), 1), std::runtime_error);
+    writer->finish();
+    ASSERT_THROW(writer->add("c", 1), std::runtime_error);
+}
+
+TEST_F(SSFileTest, testRejectsOtherFormats) {
+    memCache->insert("key", 1);
+    SSFileCreator::newFile(fileDirectory, 0, {}, memCache.get(), {});
+    auto path = std::filesystem::path(fileDirectory) / SSFileCreator::filename(0);
+    ASSERT_EQ(SSFileCreator::loadFile(path)->get("key").value, DbValue(1));
+
+    // The header starts with the magic number and then the format version
+    auto overwrite = [&path](std::streamoff pos, uint32_t value){
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(pos);
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    overwrite(sizeof(uint32_t), SSTable::ssFileFormatVersion + 1);
+    ASSERT_THROW(SSFileCreator::loadFile(path), std::runtime_error);
+    overwrite(0, 0);
+    ASSERT_THROW(SSFileCreator::loadFile(path), std::runtime_error);
+    std::filesystem::resize_file(path, 2);
+    ASSERT_THROW(SSFileCreator::loadFile(path), std::runtime_error);
+}
+
+TEST_F(SSFileTest, testParallelEncode) {
+    auto valueLogDirectory = std::filesystem::temp_directory_path() / "ssfile_parallel_encode_vlog";
+    std::filesystem::remove_all(valueLogDirectory);
+    std::filesystem::create_directories(valueLogDirectory);
+    ValueLog valueLog(valueLogDirectory, true);
+
+    SSFileOptions options;
+    options.filterType = FilterType::BLOOM;
+    options.prefixExtractor = PrefixExtractor::upToDelimiter(':');
+    options.valueLogThreshold = 2000;
+    options.encodeThreads = 4;
+    auto writer = SSFileCreator::newWriter(fileDirectory, 0, options, &valueLog);
+    std::map<std::string, DbValue> mirror;
+    std::set<std::string> tombstones;
+    // Enough entries for many encode blocks, with keys of every chunk size and some values in the value log
+    for (int i = 0; i < 20000; i++){
+        auto number = std::to_string(i);
+        auto key = "tenant" + std::to_string(i / 2000) + ":" + std::string(6 - number.size(), '0') + number + std::string(i % 300, 'k');
+        if (i % 11 == 0){
+            tombstones.insert(key);
+            writer->addTombstone(key);
             continue;
         }
 
-        ASSERT_EQ(val, value);
+        DbValue value = i % 97 == 0 ? DbValue(std::string(3000, 'l')) : DbValue(std::string(100 + i % 37, 'v'));
+        mirror[key] = value;
+        writer->add(key, value);
+    }
+
+    auto ssFile = writer->finish();
+    for (const auto& [key, val] : mirror){
+        auto read = ssFile->get(key);
+        ASSERT_EQ(read.type, KEY_FOUND);
+        auto value = read.valuePointer.has_value() ? valueLog.read(read.valuePointer.value()) : read.value.value();
+        ASSERT_EQ(value, val);
     }
 
     for (const auto& key : tombstones){
         ASSERT_EQ(ssFile->get(key).type, KEY_TOMBSTONE);
     }
 
-    auto keyValuesNotInserted = workloadGenerator->generateRandomKeyValues(30, 256);
-    for (const auto& [key, val] : keyValuesNotInserted){
-        ASSERT_EQ(ssFile->get(key).type, KEY_NOT_FOUND);
+    ASSERT_EQ(ssFile->scanPrefix("tenant3:").size(), 2000);
+    ASSERT_FALSE(ssFile->canContainPrefix("tenant10:"));
+}
+
+TEST_F(SSFileTest, testAsyncReadBackends) {
+    std::map<std::string, DbValue> mirror;
+    std::set<std::string> tombstones;
+    auto workload = workloadGenerator->generateRandomWorkload(20000, 20);
+    populate(workload, mirror, tombstones, memCache.get());
+
+    std::vector<std::string> keys;
+    for (const auto& [key, val] : mirror){
+        keys.push_back(key);
+    }
+    keys.insert(keys.end(), tombstones.begin(), tombstones.end());
+    for (const auto& [key, val] : workloadGenerator->generateRandomKeyValues(30, 256)){
+        keys.push_back(key);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    for (auto backend : {ReadBackend::IO_URING, ReadBackend::THREAD_POOL}){
+        SSFileOptions options;
+        options.learnedIndex = backend == ReadBackend::IO_URING;
+        options.readBackend = backend;
+        auto ssFile = SSFileCreator::newFile(fileDirectory, 0, options, memCache.get(), tombstones);
+
+        auto reads = ssFile->multiGet(keys);
+        ASSERT_EQ(reads.size(), keys.size());
+        for (size_t i = 0; i < keys.size(); i++){
+            auto read = ssFile->get(keys[i]);
+            ASSERT_EQ(reads[i].type, read.type);
+            ASSERT_EQ(reads[i].value.has_value(), read.value.has_value());
+            if (read.value.has_value()){
+                ASSERT_EQ(reads[i].value.value(), read.value.value());
+            }
+        }
+
+        ASSERT_EQ(ssFile->scanPrefix("").size(), mirror.size() + tombstones.size());
+    }
+}
+
+TEST_F(SSFileTest, testDirectWrites) {
+    SSFileOptions options;
+    options.filterType = FilterType::BLOOM;
+    options.directWrites = true;
+    // Under one block, and several write buffers, so the header is written both with the last flush and on its own
+    for (int numKeys : {10, 5000}){
+        auto writer = SSFileCreator::newWriter(fileDirectory, 0, options);
+        std::map<std::string, DbValue> mirror;
+        for (int i = 0; i < numKeys; i++){
+            auto number = std::to_string(i);
+            auto key = "key" + std::string(6 - number.size(), '0') + number;
+            DbValue value = std::string(500 + i % 13, 'v');
+            mirror[key] = value;
+            writer->add(key, value);
+        }
+
+        auto ssFile = writer->finish();
+        assertFileMatches(ssFile.get(), mirror, {});
+        ASSERT_EQ(ssFile->get("missing").type, KEY_NOT_FOUND);
+        ASSERT_EQ(ssFile->scanPrefix("").size(), numKeys);
+    }
+}
+
+TEST_F(SSFileTest, testCursor) {
+    std::map<std::string, std::optional<DbValue>> mirror;
+    auto writer = SSFileCreator::newWriter(fileDirectory, 0, SSFileOptions{});
+    // Keys of several lengths, so the cursor merges chunks, and enough values for readahead to reach its limit
+    for (int i = 0; i < 5000; i++){
+        auto number = std::to_string(i);
+        auto key = "key" + std::string(6 - number.size(), '0') + number + std::string(i % 40, 'k');
+        if (i % 9 == 0){
+            mirror[key] = std::nullopt;
+            writer->addTombstone(key);
+        } else {
+            DbValue value = std::string(1000 + i % 13, static_cast<char>('a' + i % 26));
+            mirror[key] = value;
+            writer->add(key, value);
+        }
+    }
+    auto ssFile = writer->finish();
+
+    for (bool readahead : {true, false}){
+        auto cursor = ssFile->newCursor(readahead);
+        for (const auto& [key, value] : mirror){
+            ASSERT_TRUE(cursor->valid());
+            ASSERT_EQ(cursor->key(), key);
+            if (value.has_value()){
+                ASSERT_EQ(cursor->read().type, KEY_FOUND);
+                ASSERT_EQ(cursor->read().value.value(), value.value());
+            } else {
+                ASSERT_EQ(cursor->read().type, KEY_TOMBSTONE);
+            }
+            cursor->next();
+        }
+        ASSERT_FALSE(cursor->valid());
     }
 }
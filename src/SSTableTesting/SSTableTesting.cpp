@@ -1,7 +1,9 @@
 #include <gtest/gtest.h>
+#include <thread>
 #include "../DatabaseEntry.h"
 #include "../SSTable/BST.hpp"
 #include "../SSTable/SSFileCreator.h"
+#include "../SSTable/SSFileCursor.h"
 #include "../Workload.h"
 #include "../SSTable/BloomFilter.h"
 #include "../SSTable/SSTableDb.h"
@@ -84,4 +86,664 @@ TEST_F(SSTableTest, testBloomFilter){
                 break;
         }
     }
-}
\ No newline at end of file
+}
+
+TEST_F(SSTableTest, testScanPrefix){
+    SSFileOptions options;
+    options.filterType = FilterType::BLOOM;
+    options.prefixExtractor = PrefixExtractor::upToDelimiter(':');
+    SSTableDb ssTableDb(std::move(memCache), "/home/pristu/Documents/School/DataIntensive/src/SSTable", true, options);
+    std::map<std::string, DbValue> mirror;
+    auto workload = workloadGenerator->generateRandomWorkload(30000, 5);
+    for (auto &action : workload){
+        auto key = "tenant" + std::to_string(action.key.size() % 10) + ":" + action.key.substr(0, 100);
+        switch (action.operation) {
+            case Operation::INSERT:
+                mirror[key] = action.value;
+                ssTableDb.insert(key, action.value);
+                break;
+            case Operation::DELETE:
+                mirror.erase(key);
+                ssTableDb.remove(key);
+                break;
+            case Operation::GET:
+                break;
+        }
+    }
+
+    for (int tenant = 0; tenant < 10; tenant++){
+        auto prefix = "tenant" + std::to_string(tenant) + ":";
+        auto scanned = ssTableDb.scanPrefix(prefix);
+        auto it = scanned.begin();
+        for (auto mirrorIt = mirror.lower_bound(prefix); mirrorIt != mirror.end() && mirrorIt->first.compare(0, prefix.size(), prefix) == 0; mirrorIt++){
+            ASSERT_NE(it, scanned.end());
+            ASSERT_EQ(it->first, mirrorIt->first);
+            it++;
+        }
+        ASSERT_EQ(it, scanned.end());
+    }
+
+    ASSERT_TRUE(ssTableDb.scanPrefix("othertenant:").empty());
+}
+
+TEST_F(SSTableTest, testMultiGet){
+    SSTableDb ssTableDb(std::move(memCache), "/home/pristu/Documents/School/DataIntensive/src/SSTable", true, true);
+    auto workload = workloadGenerator->generateRandomWorkload(30000, 5);
+    std::vector<std::string> keys;
+    for (auto &action : workload){
+        switch (action.operation) {
+            case Operation::INSERT:
+                ssTableDb.insert(action.key, action.value);
+                break;
+            case Operation::DELETE:
+                ssTableDb.remove(action.key);
+                break;
+            case Operation::GET:
+                keys.push_back(action.key);
+                break;
+        }
+    }
+
+    auto results = ssTableDb.multiGet(keys);
+    ASSERT_EQ(results.size(), keys.size());
+    for (size_t i = 0; i < keys.size(); i++){
+        ASSERT_EQ(results[i], ssTableDb.get(keys[i]));
+    }
+}
+
+TEST_F(SSTableTest, testValueLog){
+    SSFileOptions options;
+    options.filterType = FilterType::BLOOM;
+    options.valueLogThreshold = 256;
+    options.valueLogFileSize = 256 * 1024;
+    SSTableDb ssTableDb(std::move(memCache), "/home/pristu/Documents/School/DataIntensive/src/SSTable", true, options);
+    std::map<std::string, DbValue> mirror;
+    auto workload = workloadGenerator->generateRandomWorkload(30000, 5);
+    for (size_t i = 0; i < workload.size(); i++){
+        auto &action = workload[i];
+        // Cycle through few distinct keys, so most large values are overwritten and become garbage
+        auto key = "key" + std::to_string(i % 5000);
+        // Half of the values are large enough to be moved to the value log
+        auto length = action.key.size() % 2 == 0 ? action.key.size() : 8;
+        DbValue value = std::string(length, 'v') + key;
+
+        switch (action.operation) {
+            case Operation::INSERT:
+                mirror[key] = value;
+                ssTableDb.insert(key, value);
+                break;
+            case Operation::DELETE:
+                mirror.erase(key);
+                ssTableDb.remove(key);
+                break;
+            case Operation::GET:
+                break;
+        }
+    }
+
+    auto assertMatchesMirror = [&](){
+        for (const auto &[key, value] : mirror){
+            ASSERT_EQ(ssTableDb.get(key), value);
+        }
+        auto scanned = ssTableDb.scanPrefix("");
+        ASSERT_EQ(scanned.size(), mirror.size());
+        for (const auto &[key, value] : scanned){
+            ASSERT_EQ(mirror.at(key), value);
+        }
+    };
+
+    assertMatchesMirror();
+    for (int i = 0; i < 3; i++){
+        ASSERT_TRUE(ssTableDb.collectValueLogGarbage());
+    }
+    assertMatchesMirror();
+}
+
+TEST_F(SSTableTest, testFlushByMemoryUsage){
+    auto directory = std::filesystem::temp_directory_path() / "sstable_flush_by_memory";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "sstables");
+    auto countFiles = [&directory](){
+        auto files = 0;
+        for (const auto &entry : std::filesystem::directory_iterator(directory / "sstables")){
+            files += SSFileCreator::isFilenameSSTable(entry.path());
+        }
+        return files;
+    };
+
+    SSFileOptions options;
+    options.memcacheFlushBytes = 256 * 1024;
+    SSTableDb ssTableDb(std::move(memCache), directory, true, options);
+    const int numLarge = 600, largeSize = 4096;
+    for (int i = 0; i < numLarge; i++){
+        ssTableDb.insert("large" + std::to_string(i), std::string(largeSize, 'v'));
+    }
+
+    // Far fewer entries than SSTable::maxMemcacheSize, but each file holds about memcacheFlushBytes of values
+    auto expectedFiles = numLarge * largeSize / options.memcacheFlushBytes;
+    auto largeFiles = countFiles();
+    ASSERT_GE(largeFiles, expectedFiles - 1);
+    ASSERT_LE(largeFiles, expectedFiles + 1);
+
+    for (int i = 0; i < numLarge; i++){
+        ssTableDb.insert("small" + std::to_string(i), i);
+    }
+    ASSERT_EQ(countFiles(), largeFiles);
+
+    for (int i = 0; i < numLarge; i++){
+        ASSERT_EQ(ssTableDb.get("large" + std::to_string(i)), DbValue(std::string(largeSize, 'v')));
+        ASSERT_EQ(ssTableDb.get("small" + std::to_string(i)), DbValue(i));
+    }
+}
+
+TEST_F(SSTableTest, testIngestSortedCsv){
+    auto directory = std::filesystem::temp_directory_path() / "sstable_ingest";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "sstables");
+    auto csvPath = directory / "ingest.csv";
+    auto key = [](int i){
+        auto number = std::to_string(i);
+        return "key" + std::string(5 - number.size(), '0') + number;
+    };
+
+    {
+        SSTableDb ssTableDb(std::move(memCache), directory, true, SSFileOptions{});
+        ssTableDb.insert(key(0), std::string("old"));
+        ssTableDb.insert("unrelated", 1);
+        ssTableDb.remove(key(1));
+
+        const int numRows = 20000;
+        std::ofstream csv(csvPath);
+        for (int i = 0; i < numRows; i++){
+            csv << key(i) << "," << intType << "," << i << "\n";
+        }
+        // The last row for a key wins
+        csv << key(numRows) << "," << stringType << ",first\n";
+        csv << key(numRows) << "," << stringType << ",second\n";
+        csv.close();
+
+        ASSERT_EQ(ssTableDb.ingestSortedCsv(csvPath), numRows + 1);
+        for (int i = 0; i < numRows; i++){
+            ASSERT_EQ(ssTableDb.get(key(i)), DbValue(i));
+        }
+        ASSERT_EQ(ssTableDb.get(key(numRows)), DbValue(std::string("second")));
+        ASSERT_EQ(ssTableDb.get("unrelated"), DbValue(1));
+
+        // An unsorted file adds nothing and leaves no staged files behind
+        csv.open(csvPath, std::ios::trunc);
+        csv << "zzz," << intType << ",1\n" << "aaa," << intType << ",2\n";
+        csv.close();
+        ASSERT_THROW(ssTableDb.ingestSortedCsv(csvPath), std::runtime_error);
+        ASSERT_EQ(ssTableDb.get("zzz"), std::nullopt);
+        for (const auto &entry : std::filesystem::directory_iterator(directory / "sstables")){
+            ASSERT_TRUE(SSFileCreator::isFilenameSSTable(entry.path()));
+        }
+    }
+
+    SSTableDb reopened(std::make_unique<BST<std::string, DbValue>>(), directory, false, SSFileOptions{});
+    ASSERT_EQ(reopened.get(key(1)), DbValue(1));
+    ASSERT_EQ(reopened.get(key(20000)), DbValue(std::string("second")));
+    ASSERT_EQ(reopened.get("unrelated"), DbValue(1));
+}
+
+TEST_F(SSTableTest, testTtl){
+    auto directory = std::filesystem::temp_directory_path() / "sstable_ttl";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "sstables");
+    auto open = [&directory](){
+        return std::make_unique<SSTableDb>(std::make_unique<BST<std::string, DbValue>>(), directory, false, SSFileOptions{});
+    };
+    const std::chrono::milliseconds ttl(300), wait(400);
+
+    open()->insert("shadowed", std::string("old"));
+
+    {
+        auto ssTableDb = open();
+        ssTableDb->insert("shadowed", std::string("new"), ttl);
+        ssTableDb->insert("expiring", 1, ttl);
+        ssTableDb->insert("lasting", 2, std::chrono::hours(1));
+        ssTableDb->insert("overwritten", 3, ttl);
+        ssTableDb->insert("overwritten", 4);
+        ASSERT_EQ(ssTableDb->get("shadowed"), DbValue(std::string("new")));
+        ASSERT_EQ(ssTableDb->get("expiring"), DbValue(1));
+
+        // Expired memcache entries hide older versions of the key in SSFiles
+        std::this_thread::sleep_for(wait);
+        ASSERT_EQ(ssTableDb->get("shadowed"), std::nullopt);
+        ASSERT_EQ(ssTableDb->get("expiring"), std::nullopt);
+        ASSERT_EQ(ssTableDb->multiGet({"expiring", "lasting", "overwritten"}),
+                  (std::vector<std::optional<DbValue>>{std::nullopt, DbValue(2), DbValue(4)}));
+        ASSERT_EQ(ssTableDb->scanPrefix("").size(), 2);
+    }
+
+    {
+        // The flush wrote the expired entries as tombstones, and kept the expiry of the others
+        auto ssTableDb = open();
+        ASSERT_EQ(ssTableDb->get("shadowed"), std::nullopt);
+        ASSERT_EQ(ssTableDb->get("lasting"), DbValue(2));
+        ssTableDb->insert("soon", 5, ttl);
+    }
+
+    auto ssTableDb = open();
+    ASSERT_EQ(ssTableDb->get("soon"), DbValue(5));
+    std::this_thread::sleep_for(wait);
+    ASSERT_EQ(ssTableDb->get("soon"), std::nullopt);
+    ASSERT_EQ(ssTableDb->scanPrefix("").size(), 2);
+
+    ssTableDb->compact();
+    ASSERT_EQ(ssTableDb->get("shadowed"), std::nullopt);
+    ASSERT_EQ(ssTableDb->get("soon"), std::nullopt);
+    ASSERT_EQ(ssTableDb->get("lasting"), DbValue(2));
+    ASSERT_EQ(ssTableDb->get("overwritten"), DbValue(4));
+    // Only the two live entries are left, in a single file
+    std::vector<std::filesystem::path> files;
+    for (const auto &entry : std::filesystem::directory_iterator(directory / "sstables")){
+        files.push_back(entry.path());
+    }
+    ASSERT_EQ(files.size(), 1);
+    auto compacted = SSFileCreator::loadFile(files[0]);
+    auto cursor = compacted->newCursor();
+    std::vector<std::string> keys;
+    for (; cursor->valid(); cursor->next()){
+        keys.push_back(cursor->key());
+        ASSERT_EQ(cursor->read().expiresAt.has_value(), cursor->key() == "lasting");
+    }
+    ASSERT_EQ(keys, (std::vector<std::string>{"lasting", "overwritten"}));
+}
+
+TEST_F(SSTableTest, testCompact){
+    auto directory = std::filesystem::temp_directory_path() / "sstable_compact";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "sstables");
+    SSFileOptions options;
+    options.valueLogThreshold = 256;
+    options.memcacheFlushBytes = 64 * 1024;
+
+    std::map<std::string, DbValue> mirror;
+    {
+        SSTableDb ssTableDb(std::move(memCache), directory, true, options);
+        auto workload = workloadGenerator->generateRandomWorkload(20000, 5);
+        for (size_t i = 0; i < workload.size(); i++){
+            auto &action = workload[i];
+            auto key = "key" + std::to_string(i % 3000);
+            auto length = action.key.size() % 2 == 0 ? action.key.size() : 8;
+            DbValue value = std::string(length, 'v') + key;
+            switch (action.operation) {
+                case Operation::INSERT:
+                    mirror[key] = value;
+                    ssTableDb.insert(key, value);
+                    break;
+                case Operation::DELETE:
+                    mirror.erase(key);
+                    ssTableDb.remove(key);
+                    break;
+                case Operation::GET:
+                    break;
+            }
+        }
+
+        ssTableDb.compact();
+        for (const auto &[key, value] : mirror){
+            ASSERT_EQ(ssTableDb.get(key), value);
+        }
+        ASSERT_EQ(ssTableDb.scanPrefix("").size(), mirror.size());
+
+        // Files flushed after a compaction are newer than the compacted file
+        ssTableDb.insert("key0", std::string("after compaction"));
+        mirror["key0"] = std::string("after compaction");
+    }
+
+    SSTableDb reopened(std::make_unique<BST<std::string, DbValue>>(), directory, false, options);
+    for (const auto &[key, value] : mirror){
+        ASSERT_EQ(reopened.get(key), value);
+    }
+    auto scanned = reopened.scanPrefix("");
+    ASSERT_EQ(scanned.size(), mirror.size());
+}
+
+TEST_F(SSTableTest, testCompactSplitsOutput){
+    auto directory = std::filesystem::temp_directory_path() / "sstable_compact_split";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "sstables");
+    SSFileOptions options;
+    options.memcacheFlushBytes = 16 * 1024 * 1024;
+
+    // Enough data for the compacted output to pass SSTable::compactionFileSize
+    std::map<std::string, DbValue> mirror;
+    {
+        SSTableDb ssTableDb(std::move(memCache), directory, true, options);
+        for (int i = 0; i < 100; i++){
+            auto key = "key" + std::to_string(1000 + i);
+            DbValue value = std::string(1024 * 1024, static_cast<char>('a' + i % 26));
+            mirror[key] = value;
+            ssTableDb.insert(key, value);
+        }
+        ssTableDb.compact();
+        for (const auto &[key, value] : mirror){
+            ASSERT_EQ(ssTableDb.get(key), value);
+        }
+    }
+
+    size_t files = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(directory / "sstables")){
+        ASSERT_LT(entry.file_size(), 2 * SSTable::compactionFileSize);
+        files++;
+    }
+    ASSERT_GE(files, 2);
+
+    SSTableDb reopened(std::make_unique<BST<std::string, DbValue>>(), directory, false, options);
+    for (const auto &[key, value] : mirror){
+        ASSERT_EQ(reopened.get(key), value);
+    }
+    ASSERT_EQ(reopened.scanPrefix("").size(), mirror.size());
+}
+
+TEST_F(SSTableTest, testCompactionFilter){
+    // Drops every key of tenant1 and divides metrics by 10
+    class TestFilter : public CompactionFilter {
+    public:
+        Decision filter(const std::string &key, const DbValue &value, DbValue &newValue) const override {
+            if (key.rfind("tenant1/", 0) == 0){
+                return Decision::DROP;
+            }
+            if (key.rfind("metric/", 0) == 0){
+                newValue = std::get<int>(value) / 10;
+                return Decision::REWRITE;
+            }
+            return Decision::KEEP;
+        }
+    };
+
+    auto directory = std::filesystem::temp_directory_path() / "sstable_compaction_filter";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "sstables");
+    SSFileOptions filtered;
+    filtered.compactionFilter = std::make_shared<TestFilter>();
+    auto open = [&directory](const SSFileOptions &options){
+        return std::make_unique<SSTableDb>(std::make_unique<BST<std::string, DbValue>>(), directory, false, options);
+    };
+
+    {
+        auto ssTableDb = open(SSFileOptions{});
+        ssTableDb->insert("tenant1/a", 1);
+        ssTableDb->insert("tenant1/b", 1);
+        ssTableDb->insert("tenant2/a", 1);
+        ssTableDb->insert("metric/cpu", 100);
+    }
+
+    {
+        // The flush writes a tombstone in place of the dropped entry, hiding the older version
+        auto ssTableDb = open(filtered);
+        ssTableDb->insert("tenant1/a", 2);
+        ssTableDb->insert("metric/memory", 500);
+        ASSERT_EQ(ssTableDb->get("tenant1/a"), DbValue(2));
+    }
+
+    auto ssTableDb = open(filtered);
+    ASSERT_EQ(ssTableDb->get("tenant1/a"), std::nullopt);
+    ASSERT_EQ(ssTableDb->get("metric/memory"), DbValue(50));
+    // Not rewritten until a compaction
+    ASSERT_EQ(ssTableDb->get("tenant1/b"), DbValue(1));
+    ASSERT_EQ(ssTableDb->get("metric/cpu"), DbValue(100));
+
+    ssTableDb->compact();
+    ASSERT_EQ(ssTableDb->get("tenant1/b"), std::nullopt);
+    ASSERT_EQ(ssTableDb->get("metric/cpu"), DbValue(10));
+    ASSERT_EQ(ssTableDb->get("metric/memory"), DbValue(5));
+    ASSERT_EQ(ssTableDb->scanPrefix(""), (std::vector<std::pair<std::string, DbValue>>{
+        {"metric/cpu", 10}, {"metric/memory", 5}, {"tenant2/a", 1}}));
+}
+
+TEST_F(SSTableTest, testMerge){
+    auto directory = std::filesystem::temp_directory_path() / "sstable_merge";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "sstables");
+    SSFileOptions options;
+    options.mergeOperator = std::make_shared<AddOperator>();
+    auto open = [&directory, &options](){
+        return std::make_unique<SSTableDb>(std::make_unique<BST<std::string, DbValue>>(), directory, false, options);
+    };
+
+    {
+        auto ssTableDb = open();
+        ssTableDb->insert("counter", 10L);
+        ssTableDb->insert("removed", 10);
+        ssTableDb->insert("other", std::string("value"));
+        // Operands are applied right away to values in the memcache, so a mismatched one is rejected
+        ASSERT_THROW(ssTableDb->merge("other", 1), std::runtime_error);
+    }
+
+    {
+        // Neither key is in the memcache, so the operands are stored as merge records
+        auto ssTableDb = open();
+        for (int i = 0; i < 5; i++){
+            ssTableDb->merge("counter", 1);
+            ssTableDb->merge("new", 2);
+        }
+        ssTableDb->remove("removed");
+        ssTableDb->merge("removed", 3);
+        ASSERT_EQ(ssTableDb->get("counter"), DbValue(15L));
+        ASSERT_EQ(ssTableDb->get("new"), DbValue(10));
+        ASSERT_EQ(ssTableDb->get("removed"), DbValue(3));
+    }
+
+    {
+        // Operands in different files fold on read
+        auto ssTableDb = open();
+        ssTableDb->merge("counter", 5L);
+        ASSERT_EQ(ssTableDb->get("counter"), DbValue(20L));
+    }
+
+    auto ssTableDb = open();
+    ASSERT_EQ(ssTableDb->get("counter"), DbValue(20L));
+    ASSERT_EQ(ssTableDb->multiGet({"counter", "new", "removed", "missing"}),
+              (std::vector<std::optional<DbValue>>{DbValue(20L), DbValue(10), DbValue(3), std::nullopt}));
+    auto expected = std::vector<std::pair<std::string, DbValue>>{
+            {"counter", 20L}, {"new", 10}, {"other", std::string("value")}, {"removed", 3}};
+    ASSERT_EQ(ssTableDb->scanPrefix(""), expected);
+
+    ssTableDb->compact();
+    ASSERT_EQ(ssTableDb->scanPrefix(""), expected);
+    std::vector<std::filesystem::path> files;
+    for (const auto &entry : std::filesystem::directory_iterator(directory / "sstables")){
+        files.push_back(entry.path());
+    }
+    ASSERT_EQ(files.size(), 1);
+    ASSERT_EQ(SSFileCreator::loadFile(files[0])->get("counter").type, KEY_FOUND);
+
+    // Operands still in the write ahead log are applied again when it is replayed
+    ssTableDb->merge("logged", 1);
+    ssTableDb->merge("logged", 1);
+    auto replayDirectory = std::filesystem::temp_directory_path() / "sstable_merge_replay";
+    std::filesystem::remove_all(replayDirectory);
+    std::filesystem::create_directories(replayDirectory / "sstables");
+    std::filesystem::copy_file(directory / "write_ahead_log.csv", replayDirectory / "write_ahead_log.csv");
+    SSTableDb replayed(std::make_unique<BST<std::string, DbValue>>(), replayDirectory, false, options);
+    ASSERT_EQ(replayed.get("logged"), DbValue(2));
+
+    auto intMax = std::numeric_limits<int>::max();
+    auto longMax = std::numeric_limits<long>::max();
+    ASSERT_EQ(AddOperator().merge(intMax, 1), DbValue(static_cast<long>(intMax) + 1));
+    ASSERT_EQ(AddOperator().merge(intMax - 1, 1), DbValue(intMax));
+    ASSERT_EQ(AddOperator().merge(-intMax, -2), DbValue(-static_cast<long>(intMax) - 2));
+    ASSERT_THROW(AddOperator().merge(longMax, 1), std::runtime_error);
+    ASSERT_THROW(AddOperator().merge(1, longMax), std::runtime_error);
+
+    ASSERT_EQ(MaxOperator().merge(3, 7L), DbValue(7L));
+    ASSERT_EQ(MaxOperator().merge(std::string("b"), std::string("a")), DbValue(std::string("b")));
+    ASSERT_EQ(StringAppendOperator(",").merge(std::string("a"), std::string("b")), DbValue(std::string("a,b")));
+    ASSERT_THROW(StringAppendOperator().merge(1, std::string("b")), std::runtime_error);
+}
+
+TEST_F(SSTableTest, testMergeWithTtl){
+    auto directory = std::filesystem::temp_directory_path() / "sstable_merge_ttl";
+    auto beforeExpiry = std::filesystem::temp_directory_path() / "sstable_merge_ttl_before_expiry";
+    auto afterExpiry = std::filesystem::temp_directory_path() / "sstable_merge_ttl_after_expiry";
+    SSFileOptions options;
+    options.mergeOperator = std::make_shared<AddOperator>();
+    for (const auto &path : {directory, beforeExpiry, afterExpiry}){
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path / "sstables");
+    }
+    const std::chrono::milliseconds ttl(300), wait(400);
+
+    SSTableDb ssTableDb(std::move(memCache), directory, false, options);
+    ssTableDb.insert("merged", 5, ttl);
+    ssTableDb.insert("expired", 5, ttl);
+    // The operand is applied to the live entry and keeps its expiry
+    ssTableDb.merge("merged", 1);
+    ASSERT_EQ(ssTableDb.get("merged"), DbValue(6));
+    std::filesystem::copy_file(directory / "write_ahead_log.csv", beforeExpiry / "write_ahead_log.csv");
+
+    std::this_thread::sleep_for(wait);
+    ASSERT_EQ(ssTableDb.get("merged"), std::nullopt);
+    // The entry had expired, so the operand becomes a value without an expiry
+    ssTableDb.merge("expired", 7);
+    ASSERT_EQ(ssTableDb.get("expired"), DbValue(7));
+    std::filesystem::copy_file(directory / "write_ahead_log.csv", afterExpiry / "write_ahead_log.csv");
+
+    // Replaying the log after the TTL has passed gives what the database returned
+    {
+        SSTableDb replayed(std::make_unique<BST<std::string, DbValue>>(), beforeExpiry, false, options);
+        ASSERT_EQ(replayed.get("merged"), std::nullopt);
+        ASSERT_EQ(replayed.get("expired"), std::nullopt);
+    }
+    SSTableDb replayed(std::make_unique<BST<std::string, DbValue>>(), afterExpiry, false, options);
+    ASSERT_EQ(replayed.get("merged"), std::nullopt);
+    ASSERT_EQ(replayed.get("expired"), DbValue(7));
+}
+
+TEST_F(SSTableTest, testMergeValueLogGarbage){
+    auto directory = std::filesystem::temp_directory_path() / "sstable_merge_value_log";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "sstables");
+    SSFileOptions options;
+    options.mergeOperator = std::make_shared<StringAppendOperator>();
+    options.valueLogThreshold = 256;
+    options.valueLogFileSize = 1024;
+    auto open = [&directory, &options](){
+        return std::make_unique<SSTableDb>(std::make_unique<BST<std::string, DbValue>>(), directory, false, options);
+    };
+    const std::string large(2000, 'v');
+
+    open()->insert("key", large);
+    open()->insert("other", large);
+
+    {
+        // The memcache only holds an operand, which still needs the value in the oldest log file
+        auto ssTableDb = open();
+        ssTableDb->merge("key", std::string("a"));
+        ASSERT_TRUE(ssTableDb->collectValueLogGarbage());
+        ASSERT_EQ(ssTableDb->get("key"), DbValue(large + "a"));
+    }
+
+    {
+        // Operands flushed after the value are applied to the value moved by garbage collection
+        auto ssTableDb = open();
+        ssTableDb->merge("key", std::string("b"));
+    }
+    auto ssTableDb = open();
+    for (int i = 0; i < 4; i++){
+        ASSERT_TRUE(ssTableDb->collectValueLogGarbage());
+    }
+    ASSERT_EQ(ssTableDb->get("key"), DbValue(large + "ab"));
+    ASSERT_EQ(ssTableDb->get("other"), DbValue(large));
+}
+
+TEST_F(SSTableTest, testMergeCompactionFilter){
+    // Caps counters at 100, drops keys starting with "tmp", and records every entry it sees
+    class CappingFilter : public CompactionFilter {
+    public:
+        Decision filter(const std::string &key, const DbValue &value, DbValue &newValue) const override {
+            seen.emplace_back(key, value);
+            if (key.rfind("tmp", 0) == 0){
+                return Decision::DROP;
+            }
+            if (std::get<int>(value) > 100){
+                newValue = 100;
+                return Decision::REWRITE;
+            }
+            return Decision::KEEP;
+        }
+
+        mutable std::vector<std::pair<std::string, DbValue>> seen;
+    };
+
+    auto directory = std::filesystem::temp_directory_path() / "sstable_merge_compaction_filter";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory / "sstables");
+    auto filter = std::make_shared<CappingFilter>();
+    SSFileOptions options;
+    options.mergeOperator = std::make_shared<AddOperator>();
+    options.compactionFilter = filter;
+    auto open = [&directory, &options](){
+        return std::make_unique<SSTableDb>(std::make_unique<BST<std::string, DbValue>>(), directory, false, options);
+    };
+
+    open()->insert("counter", 90);
+    {
+        auto ssTableDb = open();
+        ssTableDb->merge("counter", 20);
+        ssTableDb->merge("tmp", 1);
+    }
+    // Flushes don't show operands to the filter, since it can't know the value they apply to
+    ASSERT_EQ(filter->seen, (std::vector<std::pair<std::string, DbValue>>{{"counter", 90}}));
+
+    auto ssTableDb = open();
+    ASSERT_EQ(ssTableDb->get("counter"), DbValue(110));
+    ASSERT_EQ(ssTableDb->get("tmp"), DbValue(1));
+
+    // Compactions show the filter the result of applying the operands
+    filter->seen.clear();
+    ssTableDb->compact();
+    ASSERT_EQ(filter->seen, (std::vector<std::pair<std::string, DbValue>>{{"counter", 110}, {"tmp", 1}}));
+    ASSERT_EQ(ssTableDb->get("counter"), DbValue(100));
+    ASSERT_EQ(ssTableDb->get("tmp"), std::nullopt);
+}
+
+TEST_F(SSTableTest, testCheckpoint){
+    auto directory = std::filesystem::temp_directory_path() / "sstable_checkpoint";
+    auto checkpoint = std::filesystem::temp_directory_path() / "sstable_checkpoint_copy";
+    std::filesystem::remove_all(directory);
+    std::filesystem::remove_all(checkpoint);
+    std::filesystem::create_directories(directory / "sstables");
+    SSFileOptions options;
+    options.valueLogThreshold = 256;
+    options.valueLogFileSize = 64 * 1024;
+    options.memcacheFlushBytes = 64 * 1024;
+
+    std::map<std::string, DbValue> mirror;
+    SSTableDb ssTableDb(std::move(memCache), directory, true, options);
+    for (int i = 0; i < 2000; i++){
+        auto key = "key" + std::to_string(i % 1500);
+        DbValue value = std::string(i % 2 == 0 ? 512 : 8, 'v') + std::to_string(i);
+        ssTableDb.insert(key, value);
+        mirror[key] = value;
+    }
+    ssTableDb.remove("key0");
+    mirror.erase("key0");
+
+    ssTableDb.createCheckpoint(checkpoint);
+    ASSERT_TRUE(std::filesystem::exists(checkpoint / "checkpoint_manifest"));
+    ASSERT_THROW(ssTableDb.createCheckpoint(checkpoint), std::runtime_error);
+    size_t linkedFiles = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(checkpoint / "sstables")){
+        ASSERT_EQ(std::filesystem::hard_link_count(entry.path()), 2);
+        linkedFiles++;
+    }
+    ASSERT_GT(linkedFiles, 0);
+
+    // Later writes, and compacting away the linked files, leave the checkpoint as it was
+    for (int i = 0; i < 1500; i++){
+        ssTableDb.insert("key" + std::to_string(i), i);
+    }
+    ssTableDb.compact();
+
+    SSTableDb copy(std::make_unique<BST<std::string, DbValue>>(), checkpoint, false, options);
+    for (const auto &[key, value] : mirror){
+        ASSERT_EQ(copy.get(key), value);
+    }
+    ASSERT_EQ(copy.get("key0"), std::nullopt);
+    ASSERT_EQ(copy.scanPrefix("").size(), mirror.size());
+    ASSERT_EQ(ssTableDb.get("key1"), DbValue(1));
+}
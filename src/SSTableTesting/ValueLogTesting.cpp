@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include "../Workload.h"
+#include "../SSTable/ValueLog.h"
+#include "../SSTable/SSTableParams.h"
+
+class ValueLogTest : public testing::Test {
+protected:
+    ValueLogTest() {
+        seed = time(nullptr);
+        std::cout << "seed for reproducibility " << std::to_string(seed) << "\n";
+        workloadGenerator = std::make_unique<WorkloadGenerator>(seed, SSTable::maxKeySize);
+    }
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "value_log_test";
+    std::unique_ptr<WorkloadGenerator> workloadGenerator;
+    unsigned int seed;
+};
+
+TEST_F(ValueLogTest, testAppendAndRead){
+    ValueLog valueLog(directory, true, 64 * 1024);
+    std::vector<std::pair<ValuePointer, DbValue>> appended;
+    for (auto &action : workloadGenerator->generateRandomWorkload(10000, 1)){
+        appended.emplace_back(valueLog.append(action.key, action.value), action.value);
+    }
+
+    ASSERT_GT(valueLog.numFiles(), 1);
+    for (const auto &[pointer, value] : appended){
+        // Doubles are stored as text, so compare the stored representation
+        ASSERT_EQ(dbValueToString(valueLog.read(pointer)), dbValueToString(value));
+    }
+}
+
+TEST_F(ValueLogTest, testReadRecords){
+    std::vector<ValueLog::Record> appended;
+    {
+        ValueLog valueLog(directory, true, 64 * 1024);
+        for (auto &action : workloadGenerator->generateRandomWorkload(10000, 1)){
+            appended.push_back({action.key, valueLog.append(action.key, action.value)});
+        }
+        valueLog.sync();
+    }
+
+    // Records must survive reopening the log
+    ValueLog valueLog(directory, false, 64 * 1024);
+    size_t i = 0;
+    for (auto fileNumber = valueLog.oldestFileNumber(); fileNumber <= valueLog.headFileNumber(); fileNumber++){
+        for (const auto &record : valueLog.readRecords(fileNumber)){
+            ASSERT_LT(i, appended.size());
+            ASSERT_EQ(record.key, appended[i].key);
+            ASSERT_EQ(record.pointer, appended[i].pointer);
+            i++;
+        }
+    }
+    ASSERT_EQ(i, appended.size());
+}
+
+TEST_F(ValueLogTest, testRemoveFile){
+    ValueLog valueLog(directory, true, 1024);
+    std::vector<ValuePointer> pointers;
+    for (auto &action : workloadGenerator->generateRandomWorkload(1000, 1)){
+        pointers.push_back(valueLog.append(action.key, action.value));
+    }
+
+    auto oldest = valueLog.oldestFileNumber();
+    auto numFiles = valueLog.numFiles();
+    valueLog.removeFile(oldest);
+    ASSERT_EQ(valueLog.numFiles(), numFiles - 1);
+    ASSERT_EQ(valueLog.oldestFileNumber(), oldest + 1);
+    ASSERT_THROW(valueLog.read(pointers.front()), std::runtime_error);
+    ASSERT_THROW(valueLog.removeFile(valueLog.headFileNumber()), std::runtime_error);
+}
+
+TEST_F(ValueLogTest, testBadPointerDoesNotBreakLaterReads){
+    ValueLog valueLog(directory, true, 64 * 1024);
+    auto pointer = valueLog.append("key", std::string("value"));
+    valueLog.sync();
+
+    auto pastEnd = pointer;
+    pastEnd.offset += 1024 * 1024;
+    ASSERT_THROW(valueLog.read(pastEnd), std::runtime_error);
+    auto truncated = pointer;
+    truncated.length++;
+    ASSERT_THROW(valueLog.read(truncated), std::runtime_error);
+    ASSERT_EQ(valueLog.read(pointer), DbValue(std::string("value")));
+}
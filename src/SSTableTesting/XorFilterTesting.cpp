@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "../DatabaseEntry.h"
+#include "../SSTable/BST.hpp"
+#include "../Workload.h"
+#include "../SSTable/XorFilter.h"
+#include "../SSTable/SSTableParams.h"
+
+class XorFilterTest : public testing::Test {
+protected:
+    XorFilterTest() {
+        seed = time(nullptr);
+        std::cout << "seed for reproducibility " << std::to_string(seed) << "\n";
+        workloadGenerator = std::make_unique<WorkloadGenerator>(seed, SSTable::maxKeySize);
+        initializeMemCache();
+    }
+
+    void SetUp() override {
+        initializeMemCache();
+    }
+
+    void initializeMemCache(){
+        memCache = std::make_unique<BST<std::string, DbValue>>();
+    }
+
+    std::unique_ptr<DbMemCache> memCache;
+    std::unique_ptr<WorkloadGenerator> workloadGenerator;
+    unsigned int seed;
+};
+
+TEST_F(XorFilterTest, testContainsInsertedKeys){
+    auto keysToInclude = workloadGenerator->generateRandomKeyValues(500, 256);
+    for (const auto& [key, value] : keysToInclude){
+        memCache->insert(key, value);
+    }
+
+    std::set<std::string> tombstones = {"removed_key_1", "removed_key_2"};
+    XorFilter filter(memCache.get(), tombstones);
+    for (const auto& [key, value] : keysToInclude){
+        ASSERT_TRUE(filter.canContainKey(key));
+    }
+
+    for (const auto& key : tombstones){
+        ASSERT_TRUE(filter.canContainKey(key));
+    }
+}
+
+TEST_F(XorFilterTest, testEmpty){
+    XorFilter filter(memCache.get(), {});
+    auto keysToExclude = workloadGenerator->generateRandomKeyValues(500, 256);
+    int falsePositives = 0;
+    for (const auto& [key, value] : keysToExclude){
+        falsePositives += filter.canContainKey(key);
+    }
+
+    ASSERT_LT(falsePositives, 20);
+}
+
+TEST_F(XorFilterTest, testFalsePositiveRate){
+    auto keysToInclude = workloadGenerator->generateRandomKeyValues(5000, 256);
+    auto keysToExclude = workloadGenerator->generateRandomKeyValues(5000, 256);
+    for (const auto& [key, value] : keysToInclude){
+        memCache->insert(key, value);
+    }
+
+    XorFilter filter(memCache.get(), {});
+    int falsePositives = 0, negatives = 0;
+    for (const auto& [key, value] : keysToExclude){
+        if (memCache->get(key).has_value()){
+            continue;
+        }
+        negatives++;
+        falsePositives += filter.canContainKey(key);
+    }
+
+    // An 8-bit fingerprint gives an expected error rate of 1/256 ~ 0.4%, using ~9.84 bits per key.
+    double errorRate = falsePositives / (double) negatives;
+    ASSERT_NEAR(errorRate, 1.0 / 256, 0.004);
+    ASSERT_LT(filter.serialize().size() * 8, 10 * memCache->size() + 512);
+}
+
+TEST_F(XorFilterTest, testSerialize){
+    auto keysToInclude = workloadGenerator->generateRandomKeyValues(1000, 256);
+    auto keysToExclude = workloadGenerator->generateRandomKeyValues(1000, 256);
+    for (const auto& [key, value] : keysToInclude){
+        memCache->insert(key, value);
+    }
+
+    XorFilter filter(memCache.get(), {});
+    XorFilter deserialized(filter.serialize());
+    for (const auto& [key, value] : keysToInclude){
+        ASSERT_TRUE(deserialized.canContainKey(key));
+    }
+
+    for (const auto& [key, value] : keysToExclude){
+        ASSERT_EQ(filter.canContainKey(key), deserialized.canContainKey(key));
+    }
+}
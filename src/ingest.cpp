@@ -0,0 +1,53 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "SSTable/SSTableDb.h"
+#include "SSTable/BST.hpp"
+
+/*
+ * Loads CSV files sorted by key into an SSTableDb, building SSFiles directly instead of inserting row by row.
+ * Every row holds "key,value_type,value", where value_type is the DbValue type index (see DatabaseEntry.h).
+ *
+ * Usage: SSTableIngest [--filter=none|bloom|xor] <database directory> <csv file>...
+ */
+
+static int usage(const char *program){
+    std::cerr << "Usage: " << program << " [--filter=none|bloom|xor] <database directory> <csv file>...\n";
+    return 1;
+}
+
+int main(int argc, char **argv){
+    SSFileOptions options;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if (arg == "--filter=none"){
+            options.filterType = FilterType::NONE;
+        } else if (arg == "--filter=bloom"){
+            options.filterType = FilterType::BLOOM;
+        } else if (arg == "--filter=xor"){
+            options.filterType = FilterType::XOR;
+        } else if (arg.rfind("--", 0) == 0){
+            return usage(argv[0]);
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() < 2){
+        return usage(argv[0]);
+    }
+
+    try {
+        SSTableDb db(std::make_unique<BST<std::string, DbValue>>(), positional[0], false, options);
+        for (size_t i = 1; i < positional.size(); i++){
+            auto entries = db.ingestSortedCsv(positional[i]);
+            std::cout << "Ingested " << entries << " entries from " << positional[i] << "\n";
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -6,6 +6,15 @@
 #include "Workload.h"
 #include "SSTable/SSTableParams.h"
 #include "SSTable/SortedMap.hpp"
+#include "SSTable/BloomFilter.h"
+#include "SSTable/XorFilter.h"
+#include "SSTable/ConcurrentSkipList.hpp"
+#include "SSTable/AdaptiveRadixTree.hpp"
+#include "SSTable/ArenaMemCache.h"
+#include "SSTable/AVLTree.hpp"
+#include "SSTable/BulkLoadMemCache.hpp"
+#include "SSTable/SSFileCursor.h"
+#include <thread>
 
 /*
  * Ideas for benchmarking
@@ -70,6 +79,12 @@ BENCHMARK_F(Fixture, random_workload_sstable_rbtree_nofilter)(benchmark::State&
     for (auto _ : state) run_workload(db, workloadGenerator->generateRandomWorkload(200000, 10));
 }
 
+BENCHMARK_F(Fixture, random_workload_sstable_avl_nofilter)(benchmark::State& state){
+    std::unique_ptr<DbMemCache> memCache(new AVLTree<std::string, DbValue>);
+    SSTableDb db(std::move(memCache), sstableDirectory, true, false);
+    for (auto _ : state) run_workload(db, workloadGenerator->generateRandomWorkload(200000, 10));
+}
+
 BENCHMARK_F(Fixture, random_workload_sstable_bst_filter)(benchmark::State& state){
     std::unique_ptr<DbMemCache> memCache(new BST<std::string, DbValue>);
     SSTableDb db(std::move(memCache), sstableDirectory, true, true);
@@ -104,4 +119,395 @@ BENCHMARK_F(Fixture, sstable_read_from_ssfile_filter)(benchmark::State &state){
     }
 }
 
+BENCHMARK_F(Fixture, sstable_get_batch_from_ssfiles)(benchmark::State &state){
+    std::unique_ptr<DbMemCache> memCache(new BST<std::string, DbValue>);
+    SSTableDb db(std::move(memCache), sstableDirectory, true, true);
+    auto workload = workloadGenerator->onlyInsertsWorkload(SSTable::maxMemcacheSize * 8);
+    run_workload(db, workload);
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < workload.size(); i += workload.size() / 500){
+        keys.push_back(workload[i].key);
+    }
+
+    for (auto _ : state){
+        for (const auto &key : keys){
+            benchmark::DoNotOptimize(db.get(key));
+        }
+    }
+}
+
+BENCHMARK_F(Fixture, sstable_multiget_batch_from_ssfiles)(benchmark::State &state){
+    std::unique_ptr<DbMemCache> memCache(new BST<std::string, DbValue>);
+    SSTableDb db(std::move(memCache), sstableDirectory, true, true);
+    auto workload = workloadGenerator->onlyInsertsWorkload(SSTable::maxMemcacheSize * 8);
+    run_workload(db, workload);
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < workload.size(); i += workload.size() / 500){
+        keys.push_back(workload[i].key);
+    }
+
+    for (auto _ : state){
+        benchmark::DoNotOptimize(db.multiGet(keys));
+    }
+}
+
+/*
+ * Increments counters held in SSFiles, either by reading them and inserting the sum (0) or with merge (1). Keys are
+ * visited round robin over more counters than the memcache holds, so a read almost always misses the memcache and
+ * searches the SSFiles, while a merge never reads.
+ */
+BENCHMARK_DEFINE_F(Fixture, sstable_counter_increment)(benchmark::State &state){
+    SSFileOptions options;
+    options.filterType = FilterType::BLOOM;
+    options.mergeOperator = std::make_shared<AddOperator>();
+    SSTableDb db(std::make_unique<BST<std::string, DbValue>>(), sstableDirectory, true, options);
+    auto workload = workloadGenerator->onlyInsertsWorkload(SSTable::maxMemcacheSize * 8);
+    for (const auto &action : workload){
+        db.insert(action.key, 0);
+    }
+
+    size_t next = 0;
+    for (auto _ : state){
+        for (int i = 0; i < 500; i++, next = (next + 1) % workload.size()){
+            const auto &key = workload[next].key;
+            if (state.range(0) == 0){
+                db.insert(key, std::get<int>(db.get(key).value()) + 1);
+            } else {
+                db.merge(key, 1);
+            }
+        }
+    }
+}
+BENCHMARK_REGISTER_F(Fixture, sstable_counter_increment)->Arg(0)->Arg(1);
+
+/*
+ * A batch of lookups against a single SSFile read with the backend state.range(0): SYNC (0), IO_URING (1) or
+ * THREAD_POOL (2). The file is in the page cache, so this measures the cost of batching rather than the disk.
+ */
+BENCHMARK_DEFINE_F(Fixture, ssfile_multiget_read_backend)(benchmark::State &state){
+    BST<std::string, DbValue> memCache;
+    auto keyValues = workloadGenerator->generateRandomKeyValues(16 * SSTable::maxMemcacheSize, 64);
+    for (const auto& [key, value] : keyValues){
+        memCache.insert(key, value);
+    }
+
+    SSFileOptions options;
+    options.readBackend = static_cast<ReadBackend>(state.range(0));
+    auto ssFile = SSFileCreator::newFile(sstableDirectory, 0, options, &memCache, {});
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < keyValues.size(); i += 64){
+        keys.push_back(keyValues[i].first);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    for (auto _ : state){
+        benchmark::DoNotOptimize(ssFile->multiGet(keys));
+    }
+}
+BENCHMARK_REGISTER_F(Fixture, ssfile_multiget_read_backend)->Arg(0)->Arg(1)->Arg(2);
+
+/*
+ * Full scan of a large SSFile with a cursor, with fixed 4 KB reads (0) or adaptive readahead (1)
+ */
+BENCHMARK_DEFINE_F(Fixture, ssfile_full_scan)(benchmark::State &state){
+    BST<std::string, DbValue> memCache;
+    for (const auto& [key, value] : workloadGenerator->generateRandomKeyValues(16 * SSTable::maxMemcacheSize, 64)){
+        memCache.insert(key, value);
+    }
+
+    auto ssFile = SSFileCreator::newFile(sstableDirectory, 0, SSFileOptions{}, &memCache, {});
+    for (auto _ : state){
+        for (auto cursor = ssFile->newCursor(state.range(0)); cursor->valid(); cursor->next()){
+            benchmark::DoNotOptimize(cursor->read());
+        }
+    }
+}
+BENCHMARK_REGISTER_F(Fixture, ssfile_full_scan)->Arg(0)->Arg(1);
+
+/*
+ * Point lookups against a single SSFile with short keys, with the key index read from disk (0), held in memory (1)
+ * or held in memory in Eytzinger order (2).
+ */
+BENCHMARK_DEFINE_F(Fixture, ssfile_get_short_keys)(benchmark::State &state){
+    BST<std::string, DbValue> memCache;
+    auto keyValues = workloadGenerator->generateRandomKeyValues(SSTable::maxMemcacheSize, 32);
+    for (const auto& [key, value] : keyValues){
+        memCache.insert(key, value);
+    }
+
+    SSFileOptions options;
+    options.keyIndexInMemory = state.range(0) >= 1;
+    options.eytzingerKeyIndex = state.range(0) == 2;
+    auto ssFile = SSFileCreator::newFile(sstableDirectory, 0, options, &memCache, {});
+    for (auto _ : state){
+        for (const auto& [key, value] : keyValues){
+            benchmark::DoNotOptimize(ssFile->get(key));
+        }
+    }
+}
+BENCHMARK_REGISTER_F(Fixture, ssfile_get_short_keys)->Arg(0)->Arg(1)->Arg(2);
+
+/*
+ * Point lookups of monotonically increasing ids, comparing the classic binary search over a key chunk with the
+ * learned index. Arguments are (learned index, key index in memory).
+ */
+BENCHMARK_DEFINE_F(Fixture, ssfile_get_sequential_ids)(benchmark::State &state){
+    BST<std::string, DbValue> memCache;
+    std::vector<std::string> keys;
+    for (int id = 0; id < SSTable::maxMemcacheSize * 4; id++){
+        auto digits = std::to_string(id * 7);
+        keys.push_back("id:" + std::string(12 - digits.size(), '0') + digits);
+        memCache.insert(keys.back(), id);
+    }
+
+    SSFileOptions options;
+    options.learnedIndex = state.range(0);
+    options.keyIndexInMemory = state.range(1);
+    auto ssFile = SSFileCreator::newFile(sstableDirectory, 0, options, &memCache, {});
+    for (auto _ : state){
+        for (const auto &key : keys){
+            benchmark::DoNotOptimize(ssFile->get(key));
+        }
+    }
+}
+BENCHMARK_REGISTER_F(Fixture, ssfile_get_sequential_ids)->Args({0, 0})->Args({1, 0})->Args({0, 1})->Args({1, 1});
+
+/*
+ * Flushing a full memcache to an SSFile with a bloom filter
+ */
+BENCHMARK_F(Fixture, ssfile_create_from_memcache)(benchmark::State &state){
+    BST<std::string, DbValue> memCache;
+    for (const auto& [key, value] : workloadGenerator->generateRandomKeyValues(SSTable::maxMemcacheSize, 64)){
+        memCache.insert(key, value);
+    }
+
+    SSFileOptions options;
+    options.filterType = FilterType::BLOOM;
+    for (auto _ : state){
+        benchmark::DoNotOptimize(SSFileCreator::newFile(sstableDirectory, 0, options, &memCache, {}));
+    }
+}
+
+/*
+ * Writing a large SSFile with a bloom filter using state.range(0) encode threads
+ */
+BENCHMARK_DEFINE_F(Fixture, ssfile_create_parallel)(benchmark::State &state){
+    BST<std::string, DbValue> memCache;
+    for (const auto& [key, value] : workloadGenerator->generateRandomKeyValues(16 * SSTable::maxMemcacheSize, 64)){
+        memCache.insert(key, value);
+    }
+
+    SSFileOptions options;
+    options.filterType = FilterType::BLOOM;
+    options.bloomFilterBits = 10 * memCache.size();
+    options.encodeThreads = state.range(0);
+    for (auto _ : state){
+        benchmark::DoNotOptimize(SSFileCreator::newFile(sstableDirectory, 0, options, &memCache, {}));
+    }
+}
+BENCHMARK_REGISTER_F(Fixture, ssfile_create_parallel)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+/*
+ * Filter memory versus false positive rate. The time reported is the time to build the filter over a full
+ * memcache, while the counters report the bits used per key and the false positive rate measured over keys
+ * that were not inserted. Bloom filters are given state.range(0) bits per key, xor filters size themselves.
+ */
+static void reportFilterCounters(benchmark::State &state, const KeyFilter &filter, const DbMemCache &memCache,
+                                 const std::vector<std::pair<std::string, DbValue>> &keysToExclude){
+    size_t falsePositives = 0, negatives = 0;
+    for (const auto& [key, value] : keysToExclude){
+        // Short random keys may collide with inserted ones, which are not false positives.
+        if (memCache.get(key).has_value()){
+            continue;
+        }
+        negatives++;
+        falsePositives += filter.canContainKey(key);
+    }
+
+    state.counters["bits_per_key"] = static_cast<double>(filter.serialize().size() * 8) / memCache.size();
+    state.counters["false_positive_rate"] = static_cast<double>(falsePositives) / negatives;
+}
+
+BENCHMARK_DEFINE_F(Fixture, filter_build_bloom)(benchmark::State &state){
+    BST<std::string, DbValue> memCache;
+    for (const auto& [key, value] : workloadGenerator->generateRandomKeyValues(SSTable::maxMemcacheSize, 64)){
+        memCache.insert(key, value);
+    }
+
+    auto numBits = state.range(0) * memCache.size();
+    for (auto _ : state){
+        benchmark::DoNotOptimize(BloomFilter(SSTable::bloomFilterHashes, numBits, &memCache, {}));
+    }
+
+    BloomFilter filter(SSTable::bloomFilterHashes, numBits, &memCache, {});
+    reportFilterCounters(state, filter, memCache, workloadGenerator->generateRandomKeyValues(100000, 64));
+}
+BENCHMARK_REGISTER_F(Fixture, filter_build_bloom)->Arg(5)->Arg(8)->Arg(10)->Arg(12)->Arg(16);
+
+BENCHMARK_F(Fixture, filter_build_xor)(benchmark::State &state){
+    BST<std::string, DbValue> memCache;
+    for (const auto& [key, value] : workloadGenerator->generateRandomKeyValues(SSTable::maxMemcacheSize, 64)){
+        memCache.insert(key, value);
+    }
+
+    for (auto _ : state){
+        benchmark::DoNotOptimize(XorFilter(&memCache, {}));
+    }
+
+    XorFilter filter(&memCache, {});
+    reportFilterCounters(state, filter, memCache, workloadGenerator->generateRandomKeyValues(100000, 64));
+}
+
+/*
+ * Inserts into a shared skiplist from state.range(0) threads, each thread inserting its own slice of the keys.
+ */
+BENCHMARK_DEFINE_F(Fixture, memcache_concurrent_insert_skiplist)(benchmark::State &state){
+    auto keyValues = workloadGenerator->generateRandomKeyValues(SSTable::maxMemcacheSize * 16, 64);
+    auto numThreads = state.range(0);
+    for (auto _ : state){
+        ConcurrentSkipList<std::string, DbValue> skipList;
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < numThreads; thread++){
+            threads.emplace_back([&, thread](){
+                for (size_t i = thread; i < keyValues.size(); i += numThreads){
+                    skipList.insert(keyValues[i].first, keyValues[i].second);
+                }
+            });
+        }
+        for (auto &thread : threads){
+            thread.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * keyValues.size());
+}
+BENCHMARK_REGISTER_F(Fixture, memcache_concurrent_insert_skiplist)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+/*
+ * Fills a memcache with keys sharing a long prefix and reads them all back, using a BST (0), SortedMap (1) or
+ * AdaptiveRadixTree (2).
+ */
+BENCHMARK_DEFINE_F(Fixture, memcache_shared_prefix_keys)(benchmark::State &state){
+    std::vector<std::string> keys;
+    for (const auto& [key, value] : workloadGenerator->generateRandomKeyValues(SSTable::maxMemcacheSize, 16)){
+        keys.push_back("tenant:0001/table:users/row:" + key);
+    }
+
+    for (auto _ : state){
+        std::unique_ptr<DbMemCache> memCache;
+        switch (state.range(0)) {
+            case 0: memCache = std::make_unique<BST<std::string, DbValue>>(); break;
+            case 1: memCache = std::make_unique<SortedMap<std::string, DbValue>>(); break;
+            default: memCache = std::make_unique<AdaptiveRadixTree<DbValue>>(); break;
+        }
+
+        for (const auto &key : keys){
+            memCache->insert(key, 0);
+        }
+        for (const auto &key : keys){
+            benchmark::DoNotOptimize(memCache->get(key));
+        }
+    }
+}
+BENCHMARK_REGISTER_F(Fixture, memcache_shared_prefix_keys)->Arg(0)->Arg(1)->Arg(2);
+
+/*
+ * Fills a memcache and clears it, like SSTableDb does for every flush, using a BST (0), SortedMap (1) or
+ * ArenaMemCache (2). The memcache is reused across iterations.
+ */
+BENCHMARK_DEFINE_F(Fixture, memcache_fill_and_clear)(benchmark::State &state){
+    auto keyValues = workloadGenerator->generateRandomKeyValues(SSTable::maxMemcacheSize, 32);
+    std::unique_ptr<DbMemCache> memCache;
+    switch (state.range(0)) {
+        case 0: memCache = std::make_unique<BST<std::string, DbValue>>(); break;
+        case 1: memCache = std::make_unique<SortedMap<std::string, DbValue>>(); break;
+        default: memCache = std::make_unique<ArenaMemCache>(); break;
+    }
+
+    for (auto _ : state){
+        for (const auto& [key, value] : keyValues){
+            memCache->insert(key, value);
+        }
+        memCache->clear();
+    }
+}
+BENCHMARK_REGISTER_F(Fixture, memcache_fill_and_clear)->Arg(0)->Arg(1)->Arg(2);
+
+/*
+ * Inserts a full memcache of time ordered ids and reads them back, using a BST (0), SortedMap (1) or AVLTree (2).
+ * Sorted inserts turn the unbalanced BST into a linked list.
+ */
+BENCHMARK_DEFINE_F(Fixture, memcache_sorted_keys)(benchmark::State &state){
+    std::vector<std::string> keys;
+    for (int id = 0; id < SSTable::maxMemcacheSize; id++){
+        auto digits = std::to_string(id);
+        keys.push_back("event:" + std::string(12 - digits.size(), '0') + digits);
+    }
+
+    for (auto _ : state){
+        std::unique_ptr<DbMemCache> memCache;
+        switch (state.range(0)) {
+            case 0: memCache = std::make_unique<BST<std::string, DbValue>>(); break;
+            case 1: memCache = std::make_unique<SortedMap<std::string, DbValue>>(); break;
+            default: memCache = std::make_unique<AVLTree<std::string, DbValue>>(); break;
+        }
+
+        for (const auto &key : keys){
+            memCache->insert(key, 0);
+        }
+        for (const auto &key : keys){
+            benchmark::DoNotOptimize(memCache->get(key));
+        }
+    }
+}
+BENCHMARK_REGISTER_F(Fixture, memcache_sorted_keys)->Arg(0)->Arg(1)->Arg(2);
+
+/*
+ * Point gets against a full memcache, using a BST (0), AVLTree (1), or the same trees with a hash index (2, 3)
+ */
+BENCHMARK_DEFINE_F(Fixture, memcache_point_get)(benchmark::State &state){
+    auto keyValues = workloadGenerator->generateRandomKeyValues(SSTable::maxMemcacheSize, 32);
+    std::unique_ptr<DbMemCache> memCache;
+    switch (state.range(0)) {
+        case 0: memCache = std::make_unique<BST<std::string, DbValue>>(); break;
+        case 1: memCache = std::make_unique<AVLTree<std::string, DbValue>>(); break;
+        case 2: memCache = std::make_unique<BST<std::string, DbValue>>(true); break;
+        default: memCache = std::make_unique<AVLTree<std::string, DbValue>>(true); break;
+    }
+
+    for (const auto& [key, value] : keyValues){
+        memCache->insert(key, value);
+    }
+
+    for (auto _ : state){
+        for (const auto& [key, value] : keyValues){
+            benchmark::DoNotOptimize(memCache->get(key));
+        }
+    }
+}
+BENCHMARK_REGISTER_F(Fixture, memcache_point_get)->Arg(0)->Arg(1)->Arg(2)->Arg(3);
+
+/*
+ * Loads a batch of entries and walks them in order, like a bulk load followed by a flush, using a BST (0),
+ * SortedMap (1) or BulkLoadMemCache (2)
+ */
+BENCHMARK_DEFINE_F(Fixture, memcache_bulk_load)(benchmark::State &state){
+    auto keyValues = workloadGenerator->generateRandomKeyValues(SSTable::maxMemcacheSize * 16, 32);
+    for (auto _ : state){
+        std::unique_ptr<DbMemCache> memCache;
+        switch (state.range(0)) {
+            case 0: memCache = std::make_unique<BST<std::string, DbValue>>(); break;
+            case 1: memCache = std::make_unique<SortedMap<std::string, DbValue>>(); break;
+            default: memCache = std::make_unique<BulkLoadMemCache<std::string, DbValue>>(); break;
+        }
+
+        for (const auto& [key, value] : keyValues){
+            memCache->insert(key, value);
+        }
+        for (const auto &entry : *memCache){
+            benchmark::DoNotOptimize(entry.key);
+        }
+    }
+}
+BENCHMARK_REGISTER_F(Fixture, memcache_bulk_load)->Arg(0)->Arg(1)->Arg(2);
+
 BENCHMARK_MAIN();
\ No newline at end of file